@@ -0,0 +1,480 @@
+#include "atlas.h"
+
+#if defined(WITH_IMAGE)
+#include <SDL3_image/SDL_image.h>
+#endif
+
+/* Texels of extruded border around every image */
+#define ATLAS_BORDER 1
+
+static bool create_page(struct Atlas *a, struct AtlasPage *page)
+{
+    SDL_zerop(page);
+    page->surface =
+        SDL_CreateSurface(a->page_size, a->page_size, SDL_PIXELFORMAT_ARGB8888);
+    if (a->renderer)
+    {
+        page->texture = SDL_CreateTexture(a->renderer, SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STATIC, a->page_size, a->page_size);
+    }
+    if (!page->surface || (a->renderer && !page->texture))
+    {
+        SDL_DestroySurface(page->surface);
+        SDL_DestroyTexture(page->texture);
+        return false;
+    }
+    if (page->texture)
+    {
+        SDL_SetTextureBlendMode(page->texture, SDL_BLENDMODE_BLEND);
+    }
+
+    page->skyline[0].x = 0;
+    page->skyline[0].y = 0;
+    page->skyline[0].w = a->page_size;
+    page->skyline_count = 1;
+
+    /* The texture starts out undefined, but only placed images are ever
+       sampled and each is marked pending as it goes in. Uploading the
+       whole page here would be 16 MB at once for a 2048 page. */
+    return true;
+}
+
+static void destroy_page(struct AtlasPage *page)
+{
+    SDL_DestroySurface(page->surface);
+    SDL_DestroyTexture(page->texture);
+    page->surface = NULL;
+    page->texture = NULL;
+}
+
+/* Lowest y at which a w x h block starting at skyline[i] fits, or -1 */
+static int skyline_fit(const struct Atlas *a, const struct AtlasPage *page,
+    int i, int w, int h)
+{
+    const int x = page->skyline[i].x;
+    int y = page->skyline[i].y;
+    int left = w;
+
+    if (x + w > a->page_size)
+    {
+        return -1;
+    }
+    while (left > 0)
+    {
+        if (page->skyline[i].y > y)
+        {
+            y = page->skyline[i].y;
+        }
+        if (y + h > a->page_size)
+        {
+            return -1;
+        }
+        left -= page->skyline[i].w;
+        i++;
+    }
+    return y;
+}
+
+/* Bottom-left heuristic: lowest top edge wins, then the narrower segment */
+static bool skyline_find(const struct Atlas *a, const struct AtlasPage *page,
+    int w, int h, int *index, int *x, int *y)
+{
+    int best_top = SDL_MAX_SINT32;
+    int best_width = SDL_MAX_SINT32;
+
+    *index = -1;
+    if (page->skyline_count >= ATLAS_MAX_SKYLINE - 1)
+    {
+        return false;
+    }
+    for (int i = 0; i < page->skyline_count; i++)
+    {
+        const int fit = skyline_fit(a, page, i, w, h);
+        if (fit < 0)
+        {
+            continue;
+        }
+        if (fit + h < best_top ||
+            (fit + h == best_top && page->skyline[i].w < best_width))
+        {
+            best_top = fit + h;
+            best_width = page->skyline[i].w;
+            *index = i;
+            *x = page->skyline[i].x;
+            *y = fit;
+        }
+    }
+    return *index >= 0;
+}
+
+static void skyline_add(struct AtlasPage *page, int index, int x, int y, int w,
+    int h)
+{
+    struct AtlasSkyline *sky = page->skyline;
+
+    SDL_memmove(&sky[index + 1], &sky[index],
+        (size_t)(page->skyline_count - index) * sizeof(*sky));
+    sky[index].x = x;
+    sky[index].y = y + h;
+    sky[index].w = w;
+    page->skyline_count++;
+
+    /* Trim or drop the segments now covered by the new one */
+    for (int i = index + 1; i < page->skyline_count; i++)
+    {
+        const int end = sky[i - 1].x + sky[i - 1].w;
+        if (sky[i].x >= end)
+        {
+            break;
+        }
+        const int shrink = end - sky[i].x;
+        sky[i].x += shrink;
+        sky[i].w -= shrink;
+        if (sky[i].w > 0)
+        {
+            break;
+        }
+        SDL_memmove(&sky[i], &sky[i + 1],
+            (size_t)(page->skyline_count - i - 1) * sizeof(*sky));
+        page->skyline_count--;
+        i--;
+    }
+
+    /* Merge neighbours at the same height */
+    for (int i = 0; i < page->skyline_count - 1; i++)
+    {
+        if (sky[i].y == sky[i + 1].y)
+        {
+            sky[i].w += sky[i + 1].w;
+            SDL_memmove(&sky[i + 1], &sky[i + 2],
+                (size_t)(page->skyline_count - i - 2) * sizeof(*sky));
+            page->skyline_count--;
+            i--;
+        }
+    }
+}
+
+/* Copies src_rect of src to (x, y) and smears its edges one texel outwards */
+static void blit_extruded(SDL_Surface *dst, SDL_Surface *src,
+    const SDL_Rect *src_rect, int x, int y)
+{
+    static const int OFFSETS[5][2] = {
+        { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }, { 0, 0 }
+    };
+    SDL_BlendMode blend;
+
+    SDL_GetSurfaceBlendMode(src, &blend);
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+    for (int i = 0; i < 5; i++)
+    {
+        SDL_Rect r = { x + OFFSETS[i][0], y + OFFSETS[i][1], src_rect->w,
+            src_rect->h };
+        SDL_BlitSurface(src, src_rect, dst, &r);
+    }
+    SDL_SetSurfaceBlendMode(src, blend);
+}
+
+/* Finds room for the entry in the current pages, opening a new page when
+   needed, and copies the pixels over. */
+static bool place(struct Atlas *a, struct AtlasEntry *entry, SDL_Surface *src,
+    const SDL_Rect *src_rect)
+{
+    const int w = src_rect->w + 2 * ATLAS_BORDER;
+    const int h = src_rect->h + 2 * ATLAS_BORDER;
+    int index, x, y;
+
+    for (int p = 0; p <= a->page_count && p < ATLAS_MAX_PAGES; p++)
+    {
+        if (p == a->page_count)
+        {
+            if (!create_page(a, &a->pages[p]))
+            {
+                return false;
+            }
+            a->page_count++;
+        }
+
+        struct AtlasPage *page = &a->pages[p];
+        if (!skyline_find(a, page, w, h, &index, &x, &y))
+        {
+            continue;
+        }
+        skyline_add(page, index, x, y, w, h);
+
+        entry->page = p;
+        entry->rect.x = x + ATLAS_BORDER;
+        entry->rect.y = y + ATLAS_BORDER;
+        entry->rect.w = src_rect->w;
+        entry->rect.h = src_rect->h;
+        blit_extruded(page->surface, src, src_rect, entry->rect.x,
+            entry->rect.y);
+
+        /* Only this image waits for the upload; the rest stay drawable */
+        entry->pending = (SDL_Rect){ x, y, w, h };
+        return true;
+    }
+    return false;
+}
+
+void atlas_init(struct Atlas *a, SDL_Renderer *renderer, int page_size)
+{
+    SDL_zerop(a);
+    a->renderer = renderer;
+
+    const int max_size = !renderer ? 0 : (int)SDL_GetNumberProperty(
+        SDL_GetRendererProperties(renderer),
+        SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, 0);
+    if (max_size > 0 && page_size > max_size)
+    {
+        page_size = max_size;
+    }
+    a->page_size = page_size;
+}
+
+void atlas_quit(struct Atlas *a)
+{
+    for (int p = 0; p < a->page_count; p++)
+    {
+        destroy_page(&a->pages[p]);
+    }
+    a->page_count = 0;
+    a->entry_count = 0;
+}
+
+int atlas_add_surface(struct Atlas *a, SDL_Surface *surface)
+{
+    int handle = 0;
+    while (handle < a->entry_count && a->entries[handle].used)
+    {
+        handle++;
+    }
+    if (handle == ATLAS_MAX_ENTRIES)
+    {
+        SDL_SetError("Atlas is out of entries");
+        return -1;
+    }
+
+    const SDL_Rect all = { 0, 0, surface->w, surface->h };
+    struct AtlasEntry *entry = &a->entries[handle];
+    if (!place(a, entry, surface, &all))
+    {
+        /* Space held by removed images may be enough once compacted */
+        if (a->removed == 0 || !atlas_repack(a) ||
+            !place(a, entry, surface, &all))
+        {
+            SDL_SetError("No room in the atlas for a %dx%d image", surface->w,
+                surface->h);
+            return -1;
+        }
+    }
+
+    if (!a->renderer)
+    {
+        /* Software drawing blends premultiplied pixels. Repacking copies
+           them as they are, so this happens once per image. */
+        SDL_Surface *page = a->pages[entry->page].surface;
+        const SDL_Rect area = { entry->rect.x - ATLAS_BORDER,
+            entry->rect.y - ATLAS_BORDER, entry->rect.w + 2 * ATLAS_BORDER,
+            entry->rect.h + 2 * ATLAS_BORDER };
+        Uint8 *pixels = (Uint8 *)page->pixels + area.y * page->pitch + area.x * 4;
+        SDL_PremultiplyAlpha(area.w, area.h, page->format, pixels, page->pitch,
+            page->format, pixels, page->pitch, false);
+    }
+
+    entry->used = true;
+    if (handle == a->entry_count)
+    {
+        a->entry_count++;
+    }
+    return handle;
+}
+
+#if defined(WITH_IMAGE)
+int atlas_load(struct Atlas *a, const char *path)
+{
+    SDL_Surface *surface = IMG_Load(path);
+    if (!surface)
+    {
+        return -1;
+    }
+    const int handle = atlas_add_surface(a, surface);
+    SDL_DestroySurface(surface);
+    return handle;
+}
+#endif
+
+void atlas_remove(struct Atlas *a, int handle)
+{
+    if (handle >= 0 && handle < a->entry_count && a->entries[handle].used)
+    {
+        a->entries[handle].used = false;
+        a->removed++;
+    }
+}
+
+static int SDLCALL compare_height(void *userdata, const void *lhs,
+    const void *rhs)
+{
+    const struct Atlas *a = (const struct Atlas *)userdata;
+    const int l = a->entries[*(const int *)lhs].rect.h;
+    const int r = a->entries[*(const int *)rhs].rect.h;
+    return r - l;
+}
+
+bool atlas_repack(struct Atlas *a)
+{
+    struct AtlasPage *old = (struct AtlasPage *)SDL_malloc(sizeof(a->pages));
+    int order[ATLAS_MAX_ENTRIES];
+    struct AtlasEntry placed[ATLAS_MAX_ENTRIES];
+    const int old_count = a->page_count;
+    int count = 0;
+
+    if (!old)
+    {
+        return false;
+    }
+    SDL_memcpy(old, a->pages, sizeof(a->pages));
+    SDL_memcpy(placed, a->entries, sizeof(placed));
+
+    for (int i = 0; i < a->entry_count; i++)
+    {
+        if (a->entries[i].used)
+        {
+            order[count++] = i;
+        }
+    }
+    SDL_qsort_r(order, (size_t)count, sizeof(*order), compare_height, a);
+
+    a->page_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const struct AtlasEntry *from = &a->entries[order[i]];
+        if (!place(a, &placed[order[i]], old[from->page].surface, &from->rect))
+        {
+            /* Leave the atlas exactly as it was */
+            for (int p = 0; p < a->page_count; p++)
+            {
+                destroy_page(&a->pages[p]);
+            }
+            SDL_memcpy(a->pages, old, sizeof(a->pages));
+            a->page_count = old_count;
+            SDL_free(old);
+            return false;
+        }
+    }
+
+    for (int p = 0; p < old_count; p++)
+    {
+        destroy_page(&old[p]);
+    }
+    SDL_free(old);
+    SDL_memcpy(a->entries, placed, sizeof(placed));
+    a->removed = 0;
+    return true;
+}
+
+/* Rows of one image on page not uploaded yet, as many as *budget pays for
+   (at least one), taken off it. False when nothing is left on the page or
+   the budget is spent. */
+static bool take_pending(struct Atlas *a, int page, Sint64 *budget,
+    SDL_Rect *dirty)
+{
+    struct AtlasEntry *entry = NULL;
+    for (int i = 0; i < a->entry_count && !entry; i++)
+    {
+        struct AtlasEntry *e = &a->entries[i];
+        if (e->used && e->page == page && !SDL_RectEmpty(&e->pending))
+        {
+            entry = e;
+        }
+    }
+    if (!entry || *budget <= 0)
+    {
+        return false;
+    }
+
+    /* Whole rows, at least one, so every call makes progress */
+    SDL_Rect *pending = &entry->pending;
+    const Sint64 row = (Sint64)pending->w * 4;
+    const int rows = (int)SDL_clamp(*budget / row, 1, pending->h);
+    *dirty = *pending;
+    dirty->h = rows;
+    pending->y += rows;
+    pending->h -= rows;
+    if (pending->h == 0)
+    {
+        SDL_zerop(pending);
+    }
+    *budget -= rows * row;
+    return true;
+}
+
+void atlas_upload(struct Atlas *a, Sint64 *budget)
+{
+    SDL_Rect r;
+
+    for (int p = 0; p < a->page_count; p++)
+    {
+        struct AtlasPage *page = &a->pages[p];
+        if (!page->texture)
+        {
+            continue;
+        }
+        while (take_pending(a, p, budget, &r))
+        {
+            const Uint8 *pixels = (const Uint8 *)page->surface->pixels +
+                                  r.y * page->surface->pitch + r.x * 4;
+            SDL_UpdateTexture(page->texture, &r, pixels, page->surface->pitch);
+        }
+    }
+}
+
+bool atlas_pending(const struct Atlas *a)
+{
+    for (int i = 0; i < a->entry_count; i++)
+    {
+        if (a->entries[i].used && !SDL_RectEmpty(&a->entries[i].pending))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Not drawable while part of it still waits for an upload */
+static bool resident(const struct AtlasEntry *entry)
+{
+    return SDL_RectEmpty(&entry->pending);
+}
+
+bool atlas_get(const struct Atlas *a, int handle, SDL_Texture **texture,
+    SDL_FRect *src)
+{
+    if (handle < 0 || handle >= a->entry_count || !a->entries[handle].used)
+    {
+        return false;
+    }
+
+    const struct AtlasEntry *entry = &a->entries[handle];
+    if (!resident(entry))
+    {
+        return false;
+    }
+    *texture = a->pages[entry->page].texture;
+    SDL_RectToFRect(&entry->rect, src);
+    return true;
+}
+
+bool atlas_get_surface(const struct Atlas *a, int handle, SDL_Surface **surface,
+    SDL_Rect *src)
+{
+    if (handle < 0 || handle >= a->entry_count || !a->entries[handle].used)
+    {
+        return false;
+    }
+
+    const struct AtlasEntry *entry = &a->entries[handle];
+    *surface = a->pages[entry->page].surface;
+    *src = entry->rect;
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Runtime texture atlas (skyline packer)
+   ---------------------------- */
+
+#define ATLAS_MAX_PAGES 4
+#define ATLAS_MAX_ENTRIES 512
+#define ATLAS_MAX_SKYLINE 512
+#define ATLAS_DEFAULT_PAGE_SIZE 2048
+
+/* Segment of the skyline: the packed area ends at height y over [x, x + w) */
+struct AtlasSkyline
+{
+    int x, y, w;
+};
+
+struct AtlasPage
+{
+    SDL_Surface *surface; /* CPU copy: source for uploads and repacking */
+    SDL_Texture *texture; /* NULL without a renderer */
+    struct AtlasSkyline skyline[ATLAS_MAX_SKYLINE];
+    int skyline_count;
+};
+
+struct AtlasEntry
+{
+    bool used;
+    int page;
+    SDL_Rect rect;        /* texels, without the extruded border */
+    SDL_Rect pending;     /* rect and border not uploaded yet, or empty */
+};
+
+/* Images are packed into a few large pages with a one-texel extruded
+   border, so linear filtering never samples a neighbour. Handles are
+   indices into entries and stay valid across repacking. */
+struct Atlas
+{
+    SDL_Renderer *renderer;
+    int page_size;
+    struct AtlasPage pages[ATLAS_MAX_PAGES];
+    int page_count;
+    struct AtlasEntry entries[ATLAS_MAX_ENTRIES];
+    int entry_count;
+    int removed;          /* freed entries whose space is still packed */
+};
+
+/* Without a renderer the pages live on the CPU only, premultiplied, for
+   the software rasterizer */
+void atlas_init(struct Atlas *a, SDL_Renderer *renderer, int page_size);
+void atlas_quit(struct Atlas *a);
+
+/* Copies surface into the atlas. Returns a handle, or -1 if it doesn't
+   fit even after repacking. */
+int atlas_add_surface(struct Atlas *a, SDL_Surface *surface);
+
+#if defined(WITH_IMAGE)
+/* IMG_Load + atlas_add_surface */
+int atlas_load(struct Atlas *a, const char *path);
+#endif
+
+/* Frees the handle. Its space is reclaimed by the next repack. */
+void atlas_remove(struct Atlas *a, int handle);
+
+/* Packs all live entries again from scratch, tallest first. */
+bool atlas_repack(struct Atlas *a);
+
+/* Uploads regions added since the last call, taking their bytes off
+   *budget. What doesn't fit is left for the next call. Cheap when nothing
+   changed. */
+void atlas_upload(struct Atlas *a, Sint64 *budget);
+
+/* True while something added hasn't been uploaded yet */
+bool atlas_pending(const struct Atlas *a);
+
+/* Fails for an image until it has been uploaded */
+bool atlas_get(const struct Atlas *a, int handle, SDL_Texture **texture,
+    SDL_FRect *src);
+
+/* The CPU copy of the page and the image's texels in it */
+bool atlas_get_surface(const struct Atlas *a, int handle, SDL_Surface **surface,
+    SDL_Rect *src);
+
+#endif /* ATLAS_H */
@@ -0,0 +1,209 @@
+#include "audiocache.h"
+
+#if defined(WITH_COOK)
+#include "cooked.h"
+#endif
+
+#if defined(WITH_MIXER)
+
+static Sint64 decoded_bytes(MIX_Audio *audio)
+{
+    SDL_AudioSpec spec;
+    const Sint64 frames = MIX_GetAudioDuration(audio);
+
+    if (frames < 0 || !MIX_GetAudioFormat(audio, &spec))
+    {
+        return 0;
+    }
+    /* Predecoded PCM is kept as float32 whatever the file holds */
+    return frames * spec.channels * (Sint64)sizeof(float);
+}
+
+static void evict(struct AudioCache *c, struct AudioCacheEntry *e)
+{
+    MIX_DestroyAudio(e->audio);
+    c->bytes -= e->bytes;
+    c->count--;
+    SDL_zerop(e);
+}
+
+void audio_cache_init(struct AudioCache *c, MIX_Mixer *mixer,
+    const struct Vfs *vfs, Sint64 budget)
+{
+    SDL_zerop(c);
+    c->mixer = mixer;
+    c->vfs = vfs;
+    c->budget = budget > 0 ? budget : AUDIO_CACHE_DEFAULT_BUDGET;
+}
+
+void audio_cache_quit(struct AudioCache *c)
+{
+    for (int i = 0; i < AUDIO_CACHE_MAX; i++)
+    {
+        if (c->entries[i].used)
+        {
+            evict(c, &c->entries[i]);
+        }
+    }
+}
+
+/* Least recently used entry nobody holds, other than keep */
+static struct AudioCacheEntry *oldest_idle(struct AudioCache *c,
+    const struct AudioCacheEntry *keep)
+{
+    struct AudioCacheEntry *oldest = NULL;
+    for (int i = 0; i < AUDIO_CACHE_MAX; i++)
+    {
+        struct AudioCacheEntry *e = &c->entries[i];
+        if (e->used && e->refs == 0 && e != keep &&
+            (!oldest || e->last_use < oldest->last_use))
+        {
+            oldest = e;
+        }
+    }
+    return oldest;
+}
+
+static void trim(struct AudioCache *c, Sint64 budget,
+    const struct AudioCacheEntry *keep)
+{
+    while (c->bytes > budget)
+    {
+        struct AudioCacheEntry *oldest = oldest_idle(c, keep);
+        if (!oldest)
+        {
+            /* Everything left is in use */
+            break;
+        }
+        evict(c, oldest);
+    }
+}
+
+void audio_cache_trim(struct AudioCache *c, Sint64 budget)
+{
+    trim(c, budget, NULL);
+}
+
+static struct AudioCacheEntry *find(struct AudioCache *c, const char *path,
+    Uint32 hash)
+{
+    for (int i = 0; i < AUDIO_CACHE_MAX; i++)
+    {
+        struct AudioCacheEntry *e = &c->entries[i];
+        if (e->used && e->hash == hash && SDL_strcmp(e->path, path) == 0)
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static struct AudioCacheEntry *insert(struct AudioCache *c, const char *path,
+    Uint32 hash, MIX_Audio *audio, int refs)
+{
+    struct AudioCacheEntry *e = NULL;
+
+    if (c->count == AUDIO_CACHE_MAX)
+    {
+        /* Every slot taken: make room by evicting one idle entry */
+        struct AudioCacheEntry *oldest = oldest_idle(c, NULL);
+        if (oldest)
+        {
+            evict(c, oldest);
+        }
+    }
+    for (int i = 0; i < AUDIO_CACHE_MAX && !e; i++)
+    {
+        if (!c->entries[i].used)
+        {
+            e = &c->entries[i];
+        }
+    }
+    if (!e)
+    {
+        MIX_DestroyAudio(audio);
+        SDL_SetError("Audio cache full of referenced entries");
+        return NULL;
+    }
+
+    e->used = true;
+    e->hash = hash;
+    SDL_strlcpy(e->path, path, sizeof(e->path));
+    e->audio = audio;
+    e->bytes = decoded_bytes(audio);
+    e->refs = refs;
+    e->last_use = ++c->clock;
+    c->bytes += e->bytes;
+    c->count++;
+
+    /* Never the new entry: an adopted clip is about to be used, and
+       freeing it would only mean decoding it again */
+    trim(c, c->budget, e);
+    if (c->bytes > c->budget)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_AUDIO,
+            "Audio cache over budget: %" SDL_PRIs64 " of %" SDL_PRIs64
+            " bytes referenced",
+            c->bytes, c->budget);
+    }
+    return e;
+}
+
+MIX_Audio *audio_cache_acquire(struct AudioCache *c, const char *path)
+{
+    const Uint32 hash = SDL_murmur3_32(path, SDL_strlen(path), 0);
+    struct AudioCacheEntry *e = find(c, path, hash);
+
+    if (e)
+    {
+        e->refs++;
+        e->last_use = ++c->clock;
+        return e->audio;
+    }
+
+    MIX_Audio *audio = NULL;
+#if defined(WITH_COOK)
+    audio = cooked_load_audio(c->vfs, c->mixer, path);
+#endif
+    if (!audio)
+    {
+        SDL_IOStream *io = vfs_open(c->vfs, path);
+        audio = io ? MIX_LoadAudio_IO(c->mixer, io, true, true) : NULL;
+    }
+    if (!audio)
+    {
+        return NULL;
+    }
+    e = insert(c, path, hash, audio, 1);
+    return e ? e->audio : NULL;
+}
+
+void audio_cache_adopt(struct AudioCache *c, const char *path,
+    MIX_Audio *audio)
+{
+    const Uint32 hash = SDL_murmur3_32(path, SDL_strlen(path), 0);
+
+    if (find(c, path, hash))
+    {
+        MIX_DestroyAudio(audio);
+        return;
+    }
+    insert(c, path, hash, audio, 0);
+}
+
+void audio_cache_release(struct AudioCache *c, MIX_Audio *audio)
+{
+    for (int i = 0; i < AUDIO_CACHE_MAX; i++)
+    {
+        struct AudioCacheEntry *e = &c->entries[i];
+        if (e->used && e->audio == audio && e->refs > 0)
+        {
+            e->refs--;
+            e->last_use = ++c->clock;
+            break;
+        }
+    }
+    audio_cache_trim(c, c->budget);
+}
+
+#endif
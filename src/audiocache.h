@@ -0,0 +1,68 @@
+#ifndef AUDIOCACHE_H
+#define AUDIOCACHE_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "vfs.h"
+
+/* ----------------------------
+   Predecoded audio cache
+   ---------------------------- */
+
+#define AUDIO_CACHE_MAX 256
+#define AUDIO_CACHE_DEFAULT_BUDGET (32 * 1024 * 1024) /* bytes of PCM */
+
+struct AudioCacheEntry
+{
+    bool used;
+    Uint32 hash;
+    char path[256];
+    MIX_Audio *audio;
+    Sint64 bytes;     /* decoded size */
+    int refs;
+    Uint64 last_use;  /* cache clock at the last acquire or release */
+};
+
+/* Predecoded MIX_Audio keyed by path. Handles are refcounted; entries
+   nobody holds stay loaded while the total fits the budget and are
+   evicted least recently used first beyond that, then simply reloaded
+   the next time they are acquired. */
+struct AudioCache
+{
+    MIX_Mixer *mixer;
+    const struct Vfs *vfs;
+    Sint64 budget;
+    Sint64 bytes;
+    Uint64 clock;
+    struct AudioCacheEntry entries[AUDIO_CACHE_MAX];
+    int count;        /* entries in use, including unreferenced ones */
+};
+
+void audio_cache_init(struct AudioCache *c, MIX_Mixer *mixer,
+    const struct Vfs *vfs, Sint64 budget);
+
+/* Destroys every entry, referenced or not */
+void audio_cache_quit(struct AudioCache *c);
+
+/* Returns the audio for path with one more reference, loading it if it
+   isn't cached. NULL on failure. */
+MIX_Audio *audio_cache_acquire(struct AudioCache *c, const char *path);
+
+/* Takes ownership of audio loaded elsewhere (e.g. on a loader thread) as
+   an unreferenced entry for path, so the next acquire finds it. If path
+   is already cached, audio is destroyed instead. */
+void audio_cache_adopt(struct AudioCache *c, const char *path,
+    MIX_Audio *audio);
+
+/* Drops a reference from audio_cache_acquire. The audio stays cached
+   until the budget needs its space. */
+void audio_cache_release(struct AudioCache *c, MIX_Audio *audio);
+
+/* Evicts unreferenced entries until the cache fits budget */
+void audio_cache_trim(struct AudioCache *c, Sint64 budget);
+#endif
+
+#endif /* AUDIOCACHE_H */
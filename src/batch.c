@@ -0,0 +1,121 @@
+#include "batch.h"
+
+bool batch_init(struct Batch *b, SDL_Renderer *renderer, int quad_capacity)
+{
+    SDL_zerop(b);
+    b->renderer = renderer;
+    b->quad_capacity = quad_capacity;
+    b->vertices = (SDL_Vertex *)SDL_malloc(
+        (size_t)quad_capacity * 4 * sizeof(*b->vertices));
+    b->indices = (int *)SDL_malloc((size_t)quad_capacity * 6 * sizeof(*b->indices));
+    if (!b->vertices || !b->indices)
+    {
+        batch_quit(b);
+        return false;
+    }
+
+    /* Every quad uses the same two triangles, so the index buffer is filled
+       once up front */
+    for (int i = 0; i < quad_capacity; i++)
+    {
+        int *idx = &b->indices[i * 6];
+        idx[0] = i * 4 + 0;
+        idx[1] = i * 4 + 1;
+        idx[2] = i * 4 + 2;
+        idx[3] = i * 4 + 2;
+        idx[4] = i * 4 + 3;
+        idx[5] = i * 4 + 0;
+    }
+    return true;
+}
+
+void batch_quit(struct Batch *b)
+{
+    SDL_free(b->vertices);
+    SDL_free(b->indices);
+    b->vertices = NULL;
+    b->indices = NULL;
+    b->quad_count = 0;
+    b->quad_capacity = 0;
+}
+
+void batch_flush(struct Batch *b)
+{
+    if (b->quad_count == 0)
+    {
+        return;
+    }
+
+    if (!b->texture)
+    {
+        SDL_SetRenderDrawBlendMode(b->renderer, b->blend);
+    }
+    SDL_RenderGeometry(b->renderer, b->texture, b->vertices, b->quad_count * 4,
+        b->indices, b->quad_count * 6);
+    b->quad_count = 0;
+}
+
+static SDL_Vertex *push_quad(struct Batch *b, SDL_Texture *texture,
+    SDL_BlendMode blend)
+{
+    if (b->quad_count > 0 && (b->texture != texture ||
+                                 (!texture && b->blend != blend)))
+    {
+        batch_flush(b);
+    }
+    if (b->quad_count == b->quad_capacity)
+    {
+        batch_flush(b);
+    }
+    b->texture = texture;
+    b->blend = blend;
+    return &b->vertices[b->quad_count++ * 4];
+}
+
+static void set_corners(SDL_Vertex *v, const SDL_FRect *r, SDL_FColor color)
+{
+    v[0].position.x = r->x;
+    v[0].position.y = r->y;
+    v[1].position.x = r->x + r->w;
+    v[1].position.y = r->y;
+    v[2].position.x = r->x + r->w;
+    v[2].position.y = r->y + r->h;
+    v[3].position.x = r->x;
+    v[3].position.y = r->y + r->h;
+    v[0].color = v[1].color = v[2].color = v[3].color = color;
+}
+
+void batch_fill_rect(struct Batch *b, const SDL_FRect *rect, SDL_FColor color,
+    SDL_BlendMode blend)
+{
+    SDL_Vertex *v = push_quad(b, NULL, blend);
+    set_corners(v, rect, color);
+    v[0].tex_coord.x = v[0].tex_coord.y = 0.0f;
+    v[1].tex_coord = v[2].tex_coord = v[3].tex_coord = v[0].tex_coord;
+}
+
+void batch_texture(struct Batch *b, SDL_Texture *texture, const SDL_FRect *src,
+    const SDL_FRect *dst, SDL_FColor tint)
+{
+    float tw, th;
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+
+    if (src && SDL_GetTextureSize(texture, &tw, &th))
+    {
+        u0 = src->x / tw;
+        v0 = src->y / th;
+        u1 = (src->x + src->w) / tw;
+        v1 = (src->y + src->h) / th;
+    }
+
+    SDL_Vertex *v = push_quad(b, texture, SDL_BLENDMODE_NONE);
+    set_corners(v, dst, tint);
+    v[0].tex_coord.x = u0;
+    v[0].tex_coord.y = v0;
+    v[1].tex_coord.x = u1;
+    v[1].tex_coord.y = v0;
+    v[2].tex_coord.x = u1;
+    v[2].tex_coord.y = v1;
+    v[3].tex_coord.x = u0;
+    v[3].tex_coord.y = v1;
+}
@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Quad batching on SDL_RenderGeometry
+   ---------------------------- */
+
+/* Quads are collected while the texture and blend mode stay the same and
+   submitted with one SDL_RenderGeometry call when that state changes, on
+   batch_flush, or when the buffers are full. Colors are baked into the
+   vertices, so differently colored quads still share a call. */
+struct Batch
+{
+    SDL_Renderer *renderer;
+
+    SDL_Texture *texture;    /* NULL for solid quads */
+    SDL_BlendMode blend;     /* draw blend mode for solid quads */
+
+    SDL_Vertex *vertices;
+    int *indices;
+    int quad_count;
+    int quad_capacity;
+};
+
+bool batch_init(struct Batch *b, SDL_Renderer *renderer, int quad_capacity);
+void batch_quit(struct Batch *b);
+
+void batch_fill_rect(struct Batch *b, const SDL_FRect *rect, SDL_FColor color,
+    SDL_BlendMode blend);
+
+/* src is in texels, NULL for the whole texture. The texture's own blend
+   mode applies. */
+void batch_texture(struct Batch *b, SDL_Texture *texture, const SDL_FRect *src,
+    const SDL_FRect *dst, SDL_FColor tint);
+
+/* Submits pending quads. Call before any direct draw on the renderer and
+   before presenting. */
+void batch_flush(struct Batch *b);
+
+#endif /* BATCH_H */
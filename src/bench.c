@@ -0,0 +1,288 @@
+#include "bench.h"
+
+#if defined(SDL_PLATFORM_WINDOWS)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/* Chance per frame, out of 1000, that an idle pointer presses or a pressed
+   pointer releases. Presses also trigger the click sound. */
+#define BENCH_PRESS_PERMILLE 50
+#define BENCH_RELEASE_PERMILLE 10
+
+static Uint32 next_random(struct Bench *b)
+{
+    /* xorshift32: cheap and identical on every platform */
+    Uint32 x = b->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    b->rng = x;
+    return x;
+}
+
+static float random_range(struct Bench *b, float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(next_random(b) & 0xFFFF) / 65535.0f;
+}
+
+bool bench_parse_arg(struct Bench *b, const char *arg)
+{
+    if (SDL_strcmp(arg, "--bench") == 0)
+    {
+        b->enabled = true;
+        return true;
+    }
+    if (SDL_strncmp(arg, "--bench=", 8) == 0)
+    {
+        b->enabled = true;
+        b->frames = SDL_atoi(arg + 8);
+        return true;
+    }
+    if (SDL_strncmp(arg, "--bench-pointers=", 17) == 0)
+    {
+        b->pointer_count = SDL_atoi(arg + 17);
+        return true;
+    }
+    if (SDL_strncmp(arg, "--bench-quads=", 14) == 0)
+    {
+        b->quad_count = SDL_max(SDL_atoi(arg + 14), 0);
+        return true;
+    }
+    if (SDL_strncmp(arg, "--bench-seed=", 13) == 0)
+    {
+        b->seed = (Uint32)SDL_strtoul(arg + 13, NULL, 0);
+        return true;
+    }
+    return false;
+}
+
+void bench_configure(struct Bench *b)
+{
+    if (b->frames <= 0)
+    {
+        b->frames = BENCH_DEFAULT_FRAMES;
+    }
+    if (b->pointer_count <= 0)
+    {
+        b->pointer_count = BENCH_DEFAULT_POINTERS;
+    }
+    if (b->pointer_count > POINTERS_MAX)
+    {
+        b->pointer_count = POINTERS_MAX;
+    }
+    if (b->seed == 0)
+    {
+        b->seed = 0x5EED1234;
+    }
+
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+}
+
+bool bench_begin(struct Bench *b)
+{
+    b->work = (Uint64 *)SDL_calloc((size_t)b->frames, sizeof(*b->work));
+    if (!b->work)
+    {
+        return false;
+    }
+    b->frame = 0;
+    b->rng = b->seed;
+    SDL_zeroa(b->pointers);
+    SDL_zeroa(b->phase_sum);
+    b->start_ns = SDL_GetTicksNS();
+    SDL_Log("bench: %d frames, %d pointers, %d quads, seed 0x%08" SDL_PRIx32,
+        b->frames, b->pointer_count, b->quad_count, b->seed);
+    return true;
+}
+
+static void push_pointer(SDL_Window *window, Uint32 type, int id, float x,
+    float y, int width, int height)
+{
+    SDL_Event event;
+
+    SDL_zero(event);
+    event.type = type;
+#if defined(SDL_PLATFORM_ANDROID)
+    event.tfinger.touchID = 1;
+    event.tfinger.fingerID = (SDL_FingerID)id;
+    event.tfinger.x = x / (float)width;
+    event.tfinger.y = y / (float)height;
+    event.tfinger.pressure = 1.0f;
+    event.tfinger.windowID = SDL_GetWindowID(window);
+#else
+    (void)width;
+    (void)height;
+    if (type == SDL_EVENT_MOUSE_MOTION)
+    {
+        event.motion.windowID = SDL_GetWindowID(window);
+        event.motion.which = (SDL_MouseID)id;
+        event.motion.x = x;
+        event.motion.y = y;
+    }
+    else
+    {
+        event.button.windowID = SDL_GetWindowID(window);
+        event.button.which = (SDL_MouseID)id;
+        event.button.button = SDL_BUTTON_LEFT;
+        event.button.down = (type == SDL_EVENT_MOUSE_BUTTON_DOWN);
+        event.button.clicks = 1;
+        event.button.x = x;
+        event.button.y = y;
+    }
+#endif
+    SDL_PushEvent(&event);
+}
+
+void bench_push_input(struct Bench *b, SDL_Window *window, int width,
+    int height)
+{
+#if defined(SDL_PLATFORM_ANDROID)
+    const Uint32 down = SDL_EVENT_FINGER_DOWN;
+    const Uint32 up = SDL_EVENT_FINGER_UP;
+    const Uint32 motion = SDL_EVENT_FINGER_MOTION;
+#else
+    const Uint32 down = SDL_EVENT_MOUSE_BUTTON_DOWN;
+    const Uint32 up = SDL_EVENT_MOUSE_BUTTON_UP;
+    const Uint32 motion = SDL_EVENT_MOUSE_MOTION;
+#endif
+
+    for (int i = 0; i < b->pointer_count; i++)
+    {
+        struct BenchPointer *ptr = &b->pointers[i];
+
+        if (!ptr->down)
+        {
+            if (next_random(b) % 1000 < BENCH_PRESS_PERMILLE)
+            {
+                ptr->down = true;
+                ptr->x = random_range(b, 0.0f, (float)width);
+                ptr->y = random_range(b, 0.0f, (float)height);
+                ptr->vx = random_range(b, -8.0f, 8.0f);
+                ptr->vy = random_range(b, -8.0f, 8.0f);
+                push_pointer(window, down, i, ptr->x, ptr->y, width, height);
+            }
+            continue;
+        }
+
+        if (next_random(b) % 1000 < BENCH_RELEASE_PERMILLE)
+        {
+            ptr->down = false;
+            push_pointer(window, up, i, ptr->x, ptr->y, width, height);
+            continue;
+        }
+
+        ptr->x += ptr->vx;
+        ptr->y += ptr->vy;
+        if (ptr->x < 0.0f || ptr->x > (float)width)
+        {
+            ptr->vx = -ptr->vx;
+            ptr->x = SDL_clamp(ptr->x, 0.0f, (float)width);
+        }
+        if (ptr->y < 0.0f || ptr->y > (float)height)
+        {
+            ptr->vy = -ptr->vy;
+            ptr->y = SDL_clamp(ptr->y, 0.0f, (float)height);
+        }
+        push_pointer(window, motion, i, ptr->x, ptr->y, width, height);
+    }
+}
+
+bool bench_record(struct Bench *b, struct Profiler *p)
+{
+    struct ProfilerFrame frame;
+
+    if (!profiler_snapshot(p, &frame, 1))
+    {
+        return false;
+    }
+
+    b->work[b->frame] = frame.work;
+    for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+    {
+        b->phase_sum[j] += frame.phase[j];
+    }
+    return ++b->frame >= b->frames;
+}
+
+void bench_quad(const struct Bench *b, int i, int width, int height,
+    SDL_FRect *rect)
+{
+    /* A hash of i instead of the rng, so drawing doesn't change the input
+       sequence */
+    Uint32 h = ((Uint32)i + b->seed) * 0x9E3779B1u;
+    h ^= h >> 15;
+    h *= 0x85EBCA77u;
+    h ^= h >> 13;
+
+    const int span_x = SDL_max(width, 1);
+    const int span_y = SDL_max(height, 1);
+    rect->x = (float)((int)((h & 0xFFFF) + (Uint32)b->frame) % span_x) -
+              BENCH_QUAD_SIZE / 2;
+    rect->y = (float)((int)((h >> 16) + (Uint32)b->frame) % span_y) -
+              BENCH_QUAD_SIZE / 2;
+    rect->w = BENCH_QUAD_SIZE;
+    rect->h = BENCH_QUAD_SIZE;
+}
+
+static Sint64 peak_rss_kb(void)
+{
+#if defined(SDL_PLATFORM_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (Sint64)(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+#if defined(SDL_PLATFORM_APPLE)
+    return (Sint64)usage.ru_maxrss / 1024; /* bytes on Apple */
+#else
+    return (Sint64)usage.ru_maxrss; /* kilobytes elsewhere */
+#endif
+#endif
+}
+
+void bench_report(struct Bench *b, struct Profiler *p, const char *renderer)
+{
+    const double seconds =
+        (double)(SDL_GetTicksNS() - b->start_ns) / SDL_NS_PER_SECOND;
+    const int n = b->frame;
+
+    if (n == 0)
+    {
+        return;
+    }
+    profiler_sort_ticks(b->work, n);
+
+    SDL_Log("bench: video %s, renderer %s", SDL_GetCurrentVideoDriver(),
+        renderer ? renderer : "none");
+    SDL_Log("bench: %d frames in %.3f s, %.1f fps", n, seconds, n / seconds);
+    SDL_Log("bench: frame work p50 %.3f p95 %.3f p99 %.3f worst %.3f ms",
+        profiler_percentile_ms(p, b->work, n, 50),
+        profiler_percentile_ms(p, b->work, n, 95),
+        profiler_percentile_ms(p, b->work, n, 99),
+        profiler_ticks_to_ms(p, b->work[n - 1]));
+    SDL_Log("bench: phase avg events %.3f update %.3f render %.3f present %.3f "
+            "ms",
+        profiler_ticks_to_ms(p, b->phase_sum[PROFILER_PHASE_EVENTS]) / n,
+        profiler_ticks_to_ms(p, b->phase_sum[PROFILER_PHASE_UPDATE]) / n,
+        profiler_ticks_to_ms(p, b->phase_sum[PROFILER_PHASE_RENDER]) / n,
+        profiler_ticks_to_ms(p, b->phase_sum[PROFILER_PHASE_PRESENT]) / n);
+    SDL_Log("bench: peak RSS %" SDL_PRIs64 " KB", peak_rss_kb());
+}
+
+void bench_quit(struct Bench *b)
+{
+    SDL_free(b->work);
+    b->work = NULL;
+}
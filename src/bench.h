@@ -0,0 +1,70 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <SDL3/SDL.h>
+
+#include "pointers.h"
+#include "profiler.h"
+
+/* ----------------------------
+   Headless benchmark (--bench)
+   ---------------------------- */
+
+#define BENCH_DEFAULT_FRAMES 1000
+#define BENCH_DEFAULT_POINTERS 10
+#define BENCH_QUAD_SIZE 32.0f
+
+struct BenchPointer
+{
+    bool down;
+    float x, y;
+    float vx, vy;
+};
+
+struct Bench
+{
+    bool enabled;
+    int frames;      /* frames to run */
+    int frame;       /* frames recorded so far */
+    int pointer_count;
+    int quad_count;  /* sprites drawn on top of the scene each frame */
+    Uint32 seed;
+    Uint32 rng;
+
+    Uint64 start_ns;
+    Uint64 *work;    /* per-frame work, for exact percentiles */
+    Uint64 phase_sum[PROFILER_PHASE_COUNT];
+
+    struct BenchPointer pointers[POINTERS_MAX];
+};
+
+/* Handles --bench[=frames], --bench-pointers=n, --bench-quads=n and
+   --bench-seed=n. Returns false for other arguments. */
+bool bench_parse_arg(struct Bench *b, const char *arg);
+
+/* Forces the offscreen/dummy video driver, the software renderer and the
+   dummy audio driver. Must run before SDL_Init. */
+void bench_configure(struct Bench *b);
+
+bool bench_begin(struct Bench *b);
+
+/* Pushes this frame's synthetic input into the SDL event queue, so it goes
+   through SDL_AppEvent like real input. */
+void bench_push_input(struct Bench *b, SDL_Window *window, int width,
+    int height);
+
+/* Where sprite i of quad_count goes this frame. The sprites are spread
+   over the window and drift a little every frame, so each frame redraws
+   them all. */
+void bench_quad(const struct Bench *b, int i, int width, int height,
+    SDL_FRect *rect);
+
+/* Records the frame the profiler just finished. Returns true once all
+   frames have run. */
+bool bench_record(struct Bench *b, struct Profiler *p);
+
+/* renderer names what drew the frames, NULL for none */
+void bench_report(struct Bench *b, struct Profiler *p, const char *renderer);
+void bench_quit(struct Bench *b);
+
+#endif /* BENCH_H */
@@ -0,0 +1,44 @@
+#ifndef COOK_H
+#define COOK_H
+
+#include <stdint.h>
+
+/* ----------------------------
+   Cooked asset format, shared by the game and tools/cook.c
+
+   header | payload
+
+   Images are raw pixels ready for SDL_CreateSurfaceFrom, sounds are raw
+   PCM ready for MIX_LoadRawAudioNoCopy, so loading one decodes nothing.
+   A cooked asset is stored under its source name plus COOK_SUFFIX. The
+   payload starts right after the header, a multiple of 16 bytes in, so it
+   stays aligned inside an archive (see pak.h). Integers are little-endian,
+   and so is the payload: every target we ship is.
+   ---------------------------- */
+
+#define COOK_MAGIC "SCOK"
+#define COOK_VERSION 1
+#define COOK_SUFFIX ".cooked"
+
+enum CookKind
+{
+    COOK_IMAGE = 1,
+    COOK_AUDIO = 2
+};
+
+struct CookHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t kind;     /* enum CookKind */
+    uint32_t format;   /* SDL_PixelFormat or SDL_AudioFormat */
+    uint32_t width;    /* images */
+    uint32_t height;
+    uint32_t pitch;
+    uint32_t channels; /* sounds */
+    uint32_t freq;
+    uint32_t reserved;
+    uint64_t size;     /* payload bytes */
+};
+
+#endif /* COOK_H */
@@ -0,0 +1,124 @@
+#include "cooked.h"
+
+#include "cook.h"
+
+SDL_COMPILE_TIME_ASSERT(cook_header, sizeof(struct CookHeader) == 48);
+
+/* Opens the cooked copy of name and reads its header. On success the
+   stream is positioned at the payload and *base points at it when the
+   stream is in memory (an archive), else it is NULL. */
+static SDL_IOStream *open_cooked(const struct Vfs *v, const char *name,
+    enum CookKind kind, struct CookHeader *header, const Uint8 **base)
+{
+    char cooked[256];
+
+    SDL_snprintf(cooked, sizeof(cooked), "%s%s", name, COOK_SUFFIX);
+    SDL_IOStream *io = vfs_open(v, cooked);
+    if (!io)
+    {
+        return NULL;
+    }
+
+    const Sint64 available = SDL_GetIOSize(io) - (Sint64)sizeof(*header);
+    if (SDL_ReadIO(io, header, sizeof(*header)) != sizeof(*header) ||
+        SDL_memcmp(header->magic, COOK_MAGIC, 4) != 0 ||
+        SDL_Swap32LE(header->version) != COOK_VERSION ||
+        SDL_Swap32LE(header->kind) != (Uint32)kind ||
+        (Sint64)SDL_Swap64LE(header->size) > available)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+            "%s: not a version %d cooked asset", cooked, COOK_VERSION);
+        SDL_CloseIO(io);
+        return NULL;
+    }
+
+    const Uint8 *mem = (const Uint8 *)SDL_GetPointerProperty(
+        SDL_GetIOProperties(io), SDL_PROP_IOSTREAM_MEMORY_POINTER, NULL);
+    *base = mem ? mem + sizeof(*header) : NULL;
+    return io;
+}
+
+SDL_Surface *cooked_load_surface(const struct Vfs *v, const char *name)
+{
+    struct CookHeader header;
+    const Uint8 *base;
+    SDL_Surface *surface = NULL;
+
+    SDL_IOStream *io = open_cooked(v, name, COOK_IMAGE, &header, &base);
+    if (!io)
+    {
+        return NULL;
+    }
+
+    const SDL_PixelFormat format = (SDL_PixelFormat)SDL_Swap32LE(header.format);
+    const int w = (int)SDL_Swap32LE(header.width);
+    const int h = (int)SDL_Swap32LE(header.height);
+    const int pitch = (int)SDL_Swap32LE(header.pitch);
+
+    if ((Uint64)pitch * (Uint64)h > SDL_Swap64LE(header.size))
+    {
+        SDL_SetError("%s: cooked image is truncated", name);
+    }
+    else if (base)
+    {
+        /* Nothing to copy: the surface borrows the archive's pages */
+        surface = SDL_CreateSurfaceFrom(w, h, format, (void *)base, pitch);
+    }
+    else
+    {
+        surface = SDL_CreateSurface(w, h, format);
+        for (int y = 0; surface && y < h; y++)
+        {
+            Uint8 *row = (Uint8 *)surface->pixels + y * surface->pitch;
+            if (SDL_ReadIO(io, row, (size_t)pitch) != (size_t)pitch)
+            {
+                SDL_DestroySurface(surface);
+                surface = NULL;
+            }
+        }
+    }
+    SDL_CloseIO(io);
+    return surface;
+}
+
+#if defined(WITH_MIXER)
+MIX_Audio *cooked_load_audio(const struct Vfs *v, MIX_Mixer *mixer,
+    const char *name)
+{
+    struct CookHeader header;
+    const Uint8 *base;
+    SDL_AudioSpec spec;
+    MIX_Audio *audio = NULL;
+
+    SDL_IOStream *io = open_cooked(v, name, COOK_AUDIO, &header, &base);
+    if (!io)
+    {
+        return NULL;
+    }
+
+    spec.format = (SDL_AudioFormat)SDL_Swap32LE(header.format);
+    spec.channels = (int)SDL_Swap32LE(header.channels);
+    spec.freq = (int)SDL_Swap32LE(header.freq);
+    const size_t size = (size_t)SDL_Swap64LE(header.size);
+
+    if (base)
+    {
+        audio = MIX_LoadRawAudioNoCopy(mixer, base, size, &spec, false);
+    }
+    else
+    {
+        /* Read straight into the buffer the audio will own */
+        void *pcm = SDL_malloc(size > 0 ? size : 1);
+        if (pcm && SDL_ReadIO(io, pcm, size) == size)
+        {
+            audio = MIX_LoadRawAudioNoCopy(mixer, pcm, size, &spec, true);
+        }
+        if (!audio)
+        {
+            SDL_free(pcm);
+        }
+    }
+    SDL_CloseIO(io);
+    return audio;
+}
+#endif
@@ -0,0 +1,30 @@
+#ifndef COOKED_H
+#define COOKED_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+#endif
+
+#include "vfs.h"
+
+/* ----------------------------
+   Loading cooked assets (see cook.h)
+   ---------------------------- */
+
+/* Both loaders open name + COOK_SUFFIX and return NULL when there is no
+   cooked copy, so callers fall back to decoding name itself. Served from
+   a mounted archive, the result points straight into its mapping, which
+   must outlive it. */
+
+SDL_Surface *cooked_load_surface(const struct Vfs *v, const char *name);
+
+#if defined(WITH_MIXER)
+/* Raw PCM in the spec it was cooked for. The mixer converts on the fly
+   if its own format turned out different. */
+MIX_Audio *cooked_load_audio(const struct Vfs *v, MIX_Mixer *mixer,
+    const char *name);
+#endif
+
+#endif /* COOKED_H */
@@ -0,0 +1,129 @@
+#include "latch.h"
+
+#define LATCH_MASK (LATCH_CAPACITY - 1)
+
+SDL_COMPILE_TIME_ASSERT(latch_capacity, (LATCH_CAPACITY & LATCH_MASK) == 0);
+
+static bool to_sample(const SDL_Event *event, struct LatchSample *out)
+{
+    struct MotionSample *s = &out->sample;
+
+    out->normalized = false;
+    switch (event->type)
+    {
+#if !defined(SDL_PLATFORM_ANDROID)
+        /* Android's mouse events are synthesized from touches */
+        case SDL_EVENT_MOUSE_MOTION:
+            s->key.kind = POINTER_MOUSE;
+            s->key.device = event->motion.which;
+            s->key.id = 0;
+            s->x = event->motion.x;
+            s->y = event->motion.y;
+            break;
+#endif
+        case SDL_EVENT_FINGER_MOTION:
+            s->key.kind = POINTER_FINGER;
+            s->key.device = event->tfinger.touchID;
+            s->key.id = event->tfinger.fingerID;
+            s->x = event->tfinger.x;
+            s->y = event->tfinger.y;
+            out->normalized = true;
+            break;
+        case SDL_EVENT_PEN_MOTION:
+            s->key.kind = POINTER_PEN;
+            s->key.device = event->pmotion.which;
+            s->key.id = 0;
+            s->x = event->pmotion.x;
+            s->y = event->pmotion.y;
+            break;
+        default:
+            return false;
+    }
+    s->timestamp = event->common.timestamp;
+    return true;
+}
+
+static bool SDLCALL latch_watch(void *userdata, SDL_Event *event)
+{
+    struct InputLatch *l = (struct InputLatch *)userdata;
+    struct LatchSample sample;
+
+    if (!to_sample(event, &sample))
+    {
+        return true;
+    }
+
+    const Uint32 tail = SDL_GetAtomicU32(&l->tail);
+    if (tail - SDL_GetAtomicU32(&l->head) == LATCH_CAPACITY)
+    {
+        SDL_AddAtomicInt(&l->dropped, 1);
+        return true;
+    }
+    l->ring[tail & LATCH_MASK] = sample;
+    SDL_SetAtomicU32(&l->tail, tail + 1);
+    return true; /* the event stays queued for SDL_AppEvent */
+}
+
+bool latch_start(struct InputLatch *l)
+{
+    SDL_SetAtomicU32(&l->head, 0);
+    SDL_SetAtomicU32(&l->tail, 0);
+    SDL_SetAtomicInt(&l->dropped, 0);
+    l->age_ns = 0;
+    l->enabled = SDL_AddEventWatch(latch_watch, l);
+    return l->enabled;
+}
+
+void latch_stop(struct InputLatch *l)
+{
+    if (l->enabled)
+    {
+        SDL_RemoveEventWatch(latch_watch, l);
+        l->enabled = false;
+    }
+}
+
+int latch_drain(struct InputLatch *l, struct MotionQueue *q, int width,
+    int height)
+{
+    /* Anything the OS delivered during update lands in the ring now */
+    SDL_PumpEvents();
+
+    const Uint32 tail = SDL_GetAtomicU32(&l->tail);
+    Uint32 head = SDL_GetAtomicU32(&l->head);
+    const int count = (int)(tail - head);
+    Uint64 newest = 0;
+
+    for (; head != tail; head++)
+    {
+        const struct LatchSample *ls = &l->ring[head & LATCH_MASK];
+        struct MotionSample sample = ls->sample;
+        if (ls->normalized)
+        {
+            sample.x *= (float)width;
+            sample.y *= (float)height;
+        }
+        if (!motion_push(q, &sample))
+        {
+            /* More distinct pointers than pending slots: keep the rest
+               for the next frame */
+            break;
+        }
+        newest = SDL_max(newest, sample.timestamp);
+    }
+    SDL_SetAtomicU32(&l->head, head);
+
+    if (newest)
+    {
+        const Uint64 now = SDL_GetTicksNS();
+        l->age_ns = now > newest ? now - newest : 0;
+    }
+
+    const int dropped = SDL_SetAtomicInt(&l->dropped, 0);
+    if (dropped > 0)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_INPUT, "late latch: %d samples dropped",
+            dropped);
+    }
+    return count - (int)(tail - head);
+}
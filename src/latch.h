@@ -0,0 +1,44 @@
+#ifndef LATCH_H
+#define LATCH_H
+
+#include <SDL3/SDL.h>
+
+#include "motion.h"
+
+/* ----------------------------
+   Late-latched pointer input (--late-latch)
+   ---------------------------- */
+
+#define LATCH_CAPACITY 1024 /* samples; power of two */
+
+struct LatchSample
+{
+    struct MotionSample sample;
+    bool normalized; /* finger coordinates, 0..1 of the window */
+};
+
+/* An event watch captures motion the moment SDL receives it, from
+   whichever thread delivers it (the UI thread on Android), into a
+   lock-free SPSC ring. SDL runs watchers one at a time, so the ring sees
+   a single producer. The main thread drains it right before rendering,
+   after pumping once more, so drawn positions are as fresh as possible
+   rather than as old as the start of the frame. */
+struct InputLatch
+{
+    bool enabled;
+    SDL_AtomicU32 head; /* next slot to read, main thread */
+    SDL_AtomicU32 tail; /* next slot to write, watcher */
+    SDL_AtomicInt dropped;
+    struct LatchSample ring[LATCH_CAPACITY];
+    Uint64 age_ns;      /* age of the newest sample at the last drain */
+};
+
+bool latch_start(struct InputLatch *l);
+void latch_stop(struct InputLatch *l);
+
+/* Pumps events and moves every captured sample into q, converting finger
+   coordinates with the window size. Returns the number of samples. */
+int latch_drain(struct InputLatch *l, struct MotionQueue *q, int width,
+    int height);
+
+#endif /* LATCH_H */
@@ -0,0 +1,101 @@
+#include "layer.h"
+
+void layer_init(struct Layer *l, SDL_Renderer *renderer, struct Batch *batch)
+{
+    SDL_zerop(l);
+    l->renderer = renderer;
+    l->batch = batch;
+}
+
+void layer_quit(struct Layer *l)
+{
+    if (l->texture)
+    {
+        SDL_DestroyTexture(l->texture);
+    }
+    SDL_zerop(l);
+}
+
+void layer_invalidate(struct Layer *l)
+{
+    l->valid = false;
+}
+
+bool layer_begin(struct Layer *l, const SDL_FRect *area)
+{
+    SDL_Rect pixels;
+    int width, height;
+
+    if (!l->renderer ||
+        !SDL_GetCurrentRenderOutputSize(l->renderer, &width, &height))
+    {
+        return false;
+    }
+
+    /* Whole pixels, so the cached quad lands exactly on the screen's */
+    pixels.x = (int)SDL_floorf(area->x);
+    pixels.y = (int)SDL_floorf(area->y);
+    pixels.w = (int)SDL_ceilf(area->x + area->w) - pixels.x;
+    pixels.h = (int)SDL_ceilf(area->y + area->h) - pixels.y;
+    if (pixels.w <= 0 || pixels.h <= 0)
+    {
+        l->valid = false;
+        return false;
+    }
+    if (l->valid && SDL_RectsEqual(&pixels, &l->area) &&
+        width == l->output_w && height == l->output_h)
+    {
+        return false;
+    }
+
+    if (!l->texture || pixels.w != l->area.w || pixels.h != l->area.h)
+    {
+        if (l->texture)
+        {
+            SDL_DestroyTexture(l->texture);
+        }
+        l->texture = SDL_CreateTexture(l->renderer, SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET, pixels.w, pixels.h);
+        if (!l->texture)
+        {
+            SDL_Log("Couldn't create a %dx%d layer (%s)", pixels.w, pixels.h,
+                SDL_GetError());
+            l->valid = false;
+            return false;
+        }
+        SDL_SetTextureBlendMode(l->texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+        SDL_SetTextureScaleMode(l->texture, SDL_SCALEMODE_NEAREST);
+    }
+    l->area = pixels;
+    l->output_w = width;
+    l->output_h = height;
+
+    /* Quads queued so far belong on the screen */
+    batch_flush(l->batch);
+    l->screen = SDL_GetRenderTarget(l->renderer);
+    SDL_SetRenderTarget(l->renderer, l->texture);
+    SDL_SetRenderDrawColor(l->renderer, 0, 0, 0, 0);
+    SDL_RenderClear(l->renderer);
+    return true;
+}
+
+void layer_end(struct Layer *l)
+{
+    batch_flush(l->batch);
+    SDL_SetRenderTarget(l->renderer, l->screen);
+    l->screen = NULL;
+    l->valid = true;
+}
+
+bool layer_draw(struct Layer *l)
+{
+    if (!l->valid)
+    {
+        return false;
+    }
+    const SDL_FRect dst = { (float)l->area.x, (float)l->area.y,
+        (float)l->area.w, (float)l->area.h };
+    batch_texture(l->batch, l->texture, NULL, &dst,
+        (SDL_FColor){ 1.0f, 1.0f, 1.0f, 1.0f });
+    return true;
+}
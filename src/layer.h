@@ -0,0 +1,57 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <SDL3/SDL.h>
+
+#include "batch.h"
+
+/* ----------------------------
+   Cached layers of static content
+   ---------------------------- */
+
+/* Content that stays put is drawn once into a render target and after
+   that shown as a single quad through the batch, until the content
+   changes, the area it covers changes, or the output is resized. The
+   target holds premultiplied pixels: blending onto transparent black
+   premultiplies, so the quad is drawn with
+   SDL_BLENDMODE_BLEND_PREMULTIPLIED and comes out as the direct draws
+   would. Usage:
+
+       if (layer_begin(&layer, &area))
+       {
+           ...draw, with area's top-left corner at 0, 0...
+           layer_end(&layer);
+       }
+       if (!layer_draw(&layer))
+       {
+           ...nothing cached, draw directly...
+       }
+*/
+struct Layer
+{
+    SDL_Renderer *renderer;
+    struct Batch *batch;
+    SDL_Texture *texture;
+    SDL_Rect area;        /* pixels covered on screen */
+    int output_w, output_h;
+    bool valid;           /* texture holds what area should show */
+    SDL_Texture *screen;  /* target to go back to, between begin and end */
+};
+
+/* Draws through batch, which must be on renderer */
+void layer_init(struct Layer *l, SDL_Renderer *renderer, struct Batch *batch);
+void layer_quit(struct Layer *l);
+
+/* The content changed, or the target lost its pixels */
+void layer_invalidate(struct Layer *l);
+
+/* Returns true if the layer has to be redrawn to cover area, with drawing
+   now going into it. False when the cached pixels are still good, when
+   area is empty, or when there is no render target. */
+bool layer_begin(struct Layer *l, const SDL_FRect *area);
+void layer_end(struct Layer *l);
+
+/* Queues the cached layer. False if there is nothing to draw. */
+bool layer_draw(struct Layer *l);
+
+#endif /* LAYER_H */
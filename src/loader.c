@@ -0,0 +1,363 @@
+#include "loader.h"
+
+#include "trace.h"
+
+#if defined(WITH_COOK)
+#include "cooked.h"
+#endif
+
+#if defined(WITH_IMAGE)
+#include <SDL3_image/SDL_image.h>
+#endif
+
+static void push(struct LoaderQueue *q, struct LoaderJob *job)
+{
+    job->next = NULL;
+    if (q->tail)
+    {
+        q->tail->next = job;
+    }
+    else
+    {
+        q->head = job;
+    }
+    q->tail = job;
+}
+
+static struct LoaderJob *pop(struct LoaderQueue *q)
+{
+    struct LoaderJob *job = q->head;
+    if (job)
+    {
+        q->head = job->next;
+        if (!q->head)
+        {
+            q->tail = NULL;
+        }
+    }
+    return job;
+}
+
+#if defined(WITH_COOK)
+/* Takes the build's cooked copy of the asset when there is one */
+static bool run_cooked(const struct Vfs *vfs, struct LoaderJob *job)
+{
+    (void)vfs;
+    switch (job->kind)
+    {
+#if defined(WITH_IMAGE)
+        case LOADER_IMAGE:
+            job->surface = cooked_load_surface(vfs, job->path);
+            return job->surface != NULL;
+#endif
+#if defined(WITH_MIXER)
+        case LOADER_AUDIO:
+            job->audio = cooked_load_audio(vfs, job->mixer, job->path);
+            return job->audio != NULL;
+#endif
+        default:
+            return false;
+    }
+}
+#endif
+
+static void load(const struct Vfs *vfs, struct LoaderJob *job)
+{
+#if defined(WITH_COOK)
+    if (run_cooked(vfs, job))
+    {
+        job->ok = true;
+        return;
+    }
+#endif
+
+    SDL_IOStream *io = vfs_open(vfs, job->path);
+
+    if (!io)
+    {
+        job->ok = false;
+        SDL_strlcpy(job->error, SDL_GetError(), sizeof(job->error));
+        return;
+    }
+
+    /* Every loader below takes ownership of io */
+    switch (job->kind)
+    {
+#if defined(WITH_IMAGE)
+        case LOADER_IMAGE:
+            job->surface = IMG_Load_IO(io, true);
+            job->ok = job->surface != NULL;
+            break;
+#endif
+#if defined(WITH_MIXER)
+        case LOADER_AUDIO:
+            job->audio = MIX_LoadAudio_IO(job->mixer, io, true, true);
+            job->ok = job->audio != NULL;
+            break;
+#endif
+#if defined(WITH_TTF)
+        case LOADER_FONT:
+            job->font = TTF_OpenFontIO(io, true, job->ptsize);
+            job->ok = job->font != NULL;
+            break;
+#endif
+        default:
+            SDL_CloseIO(io);
+            SDL_SetError("Asset type not compiled in");
+            job->ok = false;
+            break;
+    }
+    if (!job->ok)
+    {
+        SDL_strlcpy(job->error, SDL_GetError(), sizeof(job->error));
+    }
+}
+
+/* Loads show up in the startup trace on their worker's track */
+static void run_job(const struct Vfs *vfs, struct LoaderJob *job)
+{
+    const int span = trace_begin(job->path);
+    load(vfs, job);
+    trace_end(span);
+}
+
+static void finish(struct Loader *l, struct LoaderJob *job)
+{
+    SDL_Event event;
+
+    SDL_LockMutex(l->lock);
+    push(&l->done, job);
+    SDL_BroadcastCondition(l->idle);
+    SDL_UnlockMutex(l->lock);
+
+    if (l->wake_event)
+    {
+        SDL_zero(event);
+        event.type = l->wake_event;
+        SDL_PushEvent(&event);
+    }
+}
+
+static int SDLCALL worker(void *data)
+{
+    struct Loader *l = (struct Loader *)data;
+
+    for (;;)
+    {
+        SDL_LockMutex(l->lock);
+        while (!l->quit && !l->pending.head)
+        {
+            SDL_WaitCondition(l->work, l->lock);
+        }
+        struct LoaderJob *job = l->quit ? NULL : pop(&l->pending);
+        SDL_UnlockMutex(l->lock);
+
+        if (!job)
+        {
+            return 0;
+        }
+        run_job(l->vfs, job);
+        finish(l, job);
+    }
+}
+
+bool loader_init(struct Loader *l, const struct Vfs *vfs)
+{
+    SDL_zerop(l);
+    l->vfs = vfs;
+    l->lock = SDL_CreateMutex();
+    l->work = SDL_CreateCondition();
+    l->idle = SDL_CreateCondition();
+    if (!l->lock || !l->work || !l->idle)
+    {
+        return false;
+    }
+    l->wake_event = SDL_RegisterEvents(1);
+
+    /* Leave a core for the main thread */
+    const int wanted = SDL_clamp(SDL_GetNumLogicalCPUCores() - 1, 1,
+        LOADER_MAX_THREADS);
+    for (int i = 0; i < wanted; i++)
+    {
+        SDL_Thread *thread = SDL_CreateThread(worker, "loader", l);
+        if (!thread)
+        {
+            break;
+        }
+        l->threads[l->thread_count++] = thread;
+    }
+    if (l->thread_count == 0)
+    {
+        SDL_Log("Loading assets synchronously (%s)", SDL_GetError());
+    }
+    return true;
+}
+
+void loader_quit(struct Loader *l)
+{
+    struct LoaderJob *job;
+
+    if (l->lock)
+    {
+        SDL_LockMutex(l->lock);
+        l->quit = true;
+        SDL_BroadcastCondition(l->work);
+        SDL_UnlockMutex(l->lock);
+    }
+    for (int i = 0; i < l->thread_count; i++)
+    {
+        SDL_WaitThread(l->threads[i], NULL);
+    }
+    l->thread_count = 0;
+
+    while ((job = pop(&l->pending)) != NULL)
+    {
+        loader_free_job(job);
+    }
+    while ((job = pop(&l->done)) != NULL)
+    {
+#if defined(WITH_IMAGE)
+        SDL_DestroySurface(job->surface);
+#endif
+#if defined(WITH_MIXER)
+        if (job->audio)
+        {
+            MIX_DestroyAudio(job->audio);
+        }
+#endif
+#if defined(WITH_TTF)
+        if (job->font)
+        {
+            TTF_CloseFont(job->font);
+        }
+#endif
+        loader_free_job(job);
+    }
+
+    SDL_DestroyCondition(l->idle);
+    SDL_DestroyCondition(l->work);
+    SDL_DestroyMutex(l->lock);
+    SDL_zerop(l);
+}
+
+static struct LoaderJob *new_job(enum LoaderKind kind, int tag,
+    const char *path)
+{
+    struct LoaderJob *job =
+        (struct LoaderJob *)SDL_calloc(1, sizeof(struct LoaderJob));
+    if (job)
+    {
+        job->kind = kind;
+        job->tag = tag;
+        SDL_strlcpy(job->path, path, sizeof(job->path));
+    }
+    return job;
+}
+
+static void submit(struct Loader *l, struct LoaderJob *job)
+{
+    if (!job)
+    {
+        return;
+    }
+    l->outstanding++;
+    if (l->thread_count == 0)
+    {
+        run_job(l->vfs, job);
+        finish(l, job);
+        return;
+    }
+
+    SDL_LockMutex(l->lock);
+    push(&l->pending, job);
+    SDL_SignalCondition(l->work);
+    SDL_UnlockMutex(l->lock);
+}
+
+#if defined(WITH_IMAGE)
+void loader_load_image(struct Loader *l, int tag, const char *path)
+{
+    submit(l, new_job(LOADER_IMAGE, tag, path));
+}
+#endif
+
+#if defined(WITH_MIXER)
+void loader_load_audio(struct Loader *l, int tag, MIX_Mixer *mixer,
+    const char *path)
+{
+    struct LoaderJob *job = new_job(LOADER_AUDIO, tag, path);
+    if (job)
+    {
+        job->mixer = mixer;
+    }
+    submit(l, job);
+}
+#endif
+
+#if defined(WITH_TTF)
+void loader_load_font(struct Loader *l, int tag, const char *path,
+    float ptsize)
+{
+    struct LoaderJob *job = new_job(LOADER_FONT, tag, path);
+    if (job)
+    {
+        job->ptsize = ptsize;
+    }
+    submit(l, job);
+}
+#endif
+
+struct LoaderJob *loader_poll(struct Loader *l, Sint64 *budget)
+{
+    struct LoaderJob *job = NULL;
+
+    if (*budget <= 0)
+    {
+        return NULL;
+    }
+
+    SDL_LockMutex(l->lock);
+    job = pop(&l->done);
+    SDL_UnlockMutex(l->lock);
+
+    if (job)
+    {
+        l->outstanding--;
+#if defined(WITH_IMAGE)
+        if (job->surface)
+        {
+            *budget -= (Sint64)job->surface->pitch * job->surface->h;
+        }
+#endif
+    }
+    return job;
+}
+
+void loader_free_job(struct LoaderJob *job)
+{
+    SDL_free(job);
+}
+
+void loader_wait(struct Loader *l)
+{
+    SDL_LockMutex(l->lock);
+    for (;;)
+    {
+        int finished = 0;
+        for (const struct LoaderJob *job = l->done.head; job; job = job->next)
+        {
+            finished++;
+        }
+        if (finished == l->outstanding)
+        {
+            break;
+        }
+        SDL_WaitCondition(l->idle, l->lock);
+    }
+    SDL_UnlockMutex(l->lock);
+}
+
+int loader_outstanding(struct Loader *l)
+{
+    return l->outstanding;
+}
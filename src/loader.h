@@ -0,0 +1,106 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <SDL3/SDL.h>
+
+#include "vfs.h"
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+#endif
+#if defined(WITH_TTF)
+#include <SDL3_ttf/SDL_ttf.h>
+#endif
+
+/* ----------------------------
+   Asynchronous asset loader
+   ---------------------------- */
+
+#define LOADER_MAX_THREADS 4
+#define LOADER_UPLOAD_BUDGET (4 * 1024 * 1024) /* pixel bytes per frame */
+
+enum LoaderKind
+{
+    LOADER_IMAGE,
+    LOADER_AUDIO,
+    LOADER_FONT,
+};
+
+struct LoaderJob
+{
+    enum LoaderKind kind;
+    int tag;              /* caller's id for the asset */
+    char path[256];       /* logical name, resolved through the VFS */
+    bool ok;
+    char error[128];      /* SDL_GetError() from the worker on failure */
+#if defined(WITH_IMAGE)
+    SDL_Surface *surface; /* decoded on the worker, uploaded by the caller */
+#endif
+#if defined(WITH_MIXER)
+    MIX_Mixer *mixer;
+    MIX_Audio *audio;     /* predecoded */
+#endif
+#if defined(WITH_TTF)
+    float ptsize;
+    TTF_Font *font;
+#endif
+    struct LoaderJob *next;
+};
+
+struct LoaderQueue
+{
+    struct LoaderJob *head;
+    struct LoaderJob *tail;
+};
+
+/* Files are read and decoded on a small worker pool. Finished jobs wait
+   for the main thread, which takes them at most LOADER_UPLOAD_BUDGET
+   bytes of pixels per frame so uploads never stall a frame for long.
+   Each finished job also pushes wake_event, so an idle main loop notices.
+   Without threads every job runs inline when submitted. */
+struct Loader
+{
+    const struct Vfs *vfs;
+    SDL_Mutex *lock;
+    SDL_Condition *work;  /* signalled when jobs are queued or on quit */
+    SDL_Condition *idle;  /* signalled when a job finishes */
+    SDL_Thread *threads[LOADER_MAX_THREADS];
+    int thread_count;
+    struct LoaderQueue pending;
+    struct LoaderQueue done;
+    int outstanding;      /* submitted and not yet taken */
+    bool quit;
+    Uint32 wake_event;
+};
+
+bool loader_init(struct Loader *l, const struct Vfs *vfs);
+
+/* Stops the workers and frees finished jobs nobody took */
+void loader_quit(struct Loader *l);
+
+#if defined(WITH_IMAGE)
+void loader_load_image(struct Loader *l, int tag, const char *path);
+#endif
+#if defined(WITH_MIXER)
+void loader_load_audio(struct Loader *l, int tag, MIX_Mixer *mixer,
+    const char *path);
+#endif
+#if defined(WITH_TTF)
+void loader_load_font(struct Loader *l, int tag, const char *path,
+    float ptsize);
+#endif
+
+/* Next finished job, or NULL when there is none or the frame's budget is
+   spent. A job's surface bytes come off *budget; the caller charges what
+   it uploads to the same budget. The caller owns the job and its result and must free the job
+   with loader_free_job. */
+struct LoaderJob *loader_poll(struct Loader *l, Sint64 *budget);
+void loader_free_job(struct LoaderJob *job);
+
+/* Blocks until every submitted job has finished */
+void loader_wait(struct Loader *l);
+
+/* Jobs submitted and not yet taken with loader_poll */
+int loader_outstanding(struct Loader *l);
+
+#endif /* LOADER_H */
@@ -0,0 +1,324 @@
+#include "logger.h"
+
+#define LOGGER_MASK (LOGGER_CAPACITY - 1)
+#define LOGGER_CATEGORIES (SDL_LOG_CATEGORY_CUSTOM + 1)
+#define LOGGER_LINE 512
+
+SDL_COMPILE_TIME_ASSERT(logger_capacity,
+    (LOGGER_CAPACITY & LOGGER_MASK) == 0);
+
+struct LogRecord
+{
+    Uint64 ns;
+    const char *fmt;
+    int category;
+    SDL_LogPriority priority;
+    int arg_count;
+    double args[LOGGER_MAX_ARGS];
+};
+
+/* Bounded MPSC queue: each slot's sequence says whether it is free for
+   the producer at that position (seq == pos) or readable (seq == pos + 1),
+   so producers only contend on the tail CAS. */
+struct LogSlot
+{
+    SDL_AtomicU32 sequence;
+    struct LogRecord record;
+};
+
+struct RateWindow
+{
+    SDL_AtomicU32 second;
+    SDL_AtomicInt count;
+    SDL_AtomicInt suppressed;
+};
+
+static struct LogSlot g_slots[LOGGER_CAPACITY];
+static SDL_AtomicU32 g_tail;
+static Uint32 g_head;            /* logger thread only */
+static SDL_AtomicInt g_dropped;  /* lost to a full queue */
+static struct RateWindow g_rates[LOGGER_CATEGORIES];
+static SDL_Thread *g_thread = NULL;
+static SDL_Semaphore *g_ready = NULL; /* posted to wake the writer */
+static SDL_AtomicInt g_sleeping; /* writer is parked on g_ready */
+static SDL_AtomicInt g_quit;
+
+/* Re-applies one numeric argument per conversion in fmt. Length
+   modifiers are replaced, since every argument comes back as a double. */
+static void format_record(const struct LogRecord *r, char *out, size_t size)
+{
+    const char *f = r->fmt;
+    size_t len = 0;
+    int arg = 0;
+
+    while (*f && len + 1 < size)
+    {
+        if (*f != '%')
+        {
+            out[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%')
+        {
+            out[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        char spec[32];
+        size_t n = 0;
+        spec[n++] = *f++;
+        while (*f && SDL_strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 4)
+        {
+            spec[n++] = *f++;
+        }
+        while (*f && SDL_strchr("hlLqjzt", *f))
+        {
+            f++;
+        }
+        const char conversion = *f ? *f++ : '\0';
+        const double value = arg < r->arg_count ? r->args[arg++] : 0.0;
+        int written;
+
+        switch (conversion)
+        {
+            case 'd':
+            case 'i':
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = SDL_snprintf(out + len, size - len, spec,
+                    (long long)value);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = SDL_snprintf(out + len, size - len, spec,
+                    (unsigned long long)(long long)value);
+                break;
+            case 'c':
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                written = SDL_snprintf(out + len, size - len, spec, (int)value);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                spec[n++] = conversion;
+                spec[n] = '\0';
+                written = SDL_snprintf(out + len, size - len, spec, value);
+                break;
+            default:
+                written = SDL_snprintf(out + len, size - len, "?");
+                break;
+        }
+        if (written > 0)
+        {
+            len += (size_t)written;
+        }
+        if (len >= size)
+        {
+            len = size - 1;
+        }
+    }
+    out[len] = '\0';
+}
+
+static void emit(const struct LogRecord *r)
+{
+    char line[LOGGER_LINE];
+    const int index = SDL_min(r->category, LOGGER_CATEGORIES - 1);
+
+    const int suppressed = SDL_SetAtomicInt(&g_rates[index].suppressed, 0);
+    if (suppressed > 0)
+    {
+        SDL_LogMessage(r->category, SDL_LOG_PRIORITY_WARN,
+            "%d messages suppressed by the rate limit", suppressed);
+    }
+
+    format_record(r, line, sizeof(line));
+    SDL_LogMessage(r->category, r->priority, "[%.3f] %s",
+        (double)r->ns / SDL_NS_PER_SECOND, line);
+}
+
+/* Returns the number of records written */
+static int drain(void)
+{
+    int count = 0;
+
+    for (;;)
+    {
+        struct LogSlot *slot = &g_slots[g_head & LOGGER_MASK];
+        if (SDL_GetAtomicU32(&slot->sequence) != g_head + 1)
+        {
+            break;
+        }
+        emit(&slot->record);
+        SDL_SetAtomicU32(&slot->sequence, g_head + LOGGER_CAPACITY);
+        g_head++;
+        count++;
+    }
+
+    const int dropped = SDL_SetAtomicInt(&g_dropped, 0);
+    if (dropped > 0)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+            "%d log messages dropped, queue full", dropped);
+    }
+    return count;
+}
+
+static int SDLCALL logger_thread(void *data)
+{
+    (void)data;
+    /* Sleeps until there is something to write, so an idle app stays idle.
+       Producers only signal while g_sleeping is set, so it is set before
+       the last look at the queue: a record published after that look
+       finds it set and wakes us. */
+    while (!SDL_GetAtomicInt(&g_quit))
+    {
+        if (drain() > 0)
+        {
+            continue;
+        }
+        SDL_SetAtomicInt(&g_sleeping, 1);
+        if (drain() == 0)
+        {
+            SDL_WaitSemaphore(g_ready);
+        }
+        SDL_SetAtomicInt(&g_sleeping, 0);
+    }
+    drain();
+    return 0;
+}
+
+void logger_init(void)
+{
+    for (Uint32 i = 0; i < LOGGER_CAPACITY; i++)
+    {
+        SDL_SetAtomicU32(&g_slots[i].sequence, i);
+    }
+    SDL_SetAtomicU32(&g_tail, 0);
+    SDL_SetAtomicInt(&g_sleeping, 0);
+    SDL_SetAtomicInt(&g_quit, 0);
+    g_head = 0;
+
+    g_ready = SDL_CreateSemaphore(0);
+    g_thread = g_ready ? SDL_CreateThread(logger_thread, "logger", NULL) : NULL;
+    if (!g_thread)
+    {
+        if (g_ready)
+        {
+            SDL_DestroySemaphore(g_ready);
+            g_ready = NULL;
+        }
+        SDL_Log("Logging synchronously, no logger thread (%s)",
+            SDL_GetError());
+    }
+}
+
+void logger_quit(void)
+{
+    if (g_thread)
+    {
+        SDL_SetAtomicInt(&g_quit, 1);
+        SDL_SignalSemaphore(g_ready);
+        SDL_WaitThread(g_thread, NULL);
+        g_thread = NULL;
+        SDL_DestroySemaphore(g_ready);
+        g_ready = NULL;
+    }
+}
+
+/* One signal per park, so a busy writer costs producers no syscalls */
+static void wake_writer(void)
+{
+    if (SDL_CompareAndSwapAtomicInt(&g_sleeping, 1, 0))
+    {
+        SDL_SignalSemaphore(g_ready);
+    }
+}
+
+/* Per-category budget over one-second windows. Racing resets at a window
+   boundary only make the limit slightly loose. */
+static bool over_rate_limit(int category, Uint64 ns)
+{
+    struct RateWindow *rate = &g_rates[SDL_min(category, LOGGER_CATEGORIES - 1)];
+    const Uint32 second = (Uint32)(ns / SDL_NS_PER_SECOND);
+
+    if (SDL_GetAtomicU32(&rate->second) != second)
+    {
+        SDL_SetAtomicU32(&rate->second, second);
+        SDL_SetAtomicInt(&rate->count, 0);
+    }
+    if (SDL_AddAtomicInt(&rate->count, 1) >= LOGGER_RATE_LIMIT)
+    {
+        SDL_AddAtomicInt(&rate->suppressed, 1);
+        return true;
+    }
+    return false;
+}
+
+void logger_write(SDL_LogPriority priority, int category, const char *fmt,
+    const double *args, int arg_count)
+{
+    if (category < 0 || priority < SDL_GetLogPriority(category))
+    {
+        return;
+    }
+
+    const Uint64 ns = SDL_GetTicksNS();
+    if (over_rate_limit(category, ns))
+    {
+        return;
+    }
+
+    struct LogRecord record;
+    record.ns = ns;
+    record.fmt = fmt;
+    record.category = category;
+    record.priority = priority;
+    record.arg_count = SDL_min(arg_count, LOGGER_MAX_ARGS);
+    SDL_memcpy(record.args, args, (size_t)record.arg_count * sizeof(*args));
+
+    if (!g_thread)
+    {
+        emit(&record);
+        return;
+    }
+
+    Uint32 pos = SDL_GetAtomicU32(&g_tail);
+    struct LogSlot *slot;
+    for (;;)
+    {
+        slot = &g_slots[pos & LOGGER_MASK];
+        const Sint32 diff = (Sint32)(SDL_GetAtomicU32(&slot->sequence) - pos);
+        if (diff == 0)
+        {
+            if (SDL_CompareAndSwapAtomicU32(&g_tail, pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            SDL_AddAtomicInt(&g_dropped, 1);
+            wake_writer();
+            return;
+        }
+        pos = SDL_GetAtomicU32(&g_tail);
+    }
+
+    slot->record = record;
+    SDL_SetAtomicU32(&slot->sequence, pos + 1);
+    wake_writer();
+}
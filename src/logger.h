@@ -0,0 +1,38 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Asynchronous logger
+   ---------------------------- */
+
+#define LOGGER_CAPACITY 1024        /* records; power of two */
+#define LOGGER_MAX_ARGS 6
+#define LOGGER_RATE_LIMIT 200       /* records per category per second */
+
+/* fmt must be a string literal: only the pointer is queued and the text
+   is formatted later on the logger thread. Arguments are numbers only
+   (no %s) and travel as doubles, converted back by their conversion
+   letter, so integers above 2^53 lose precision. */
+#define LOG_DEBUG(category, fmt, ...)                                       \
+    logger_write(SDL_LOG_PRIORITY_DEBUG, (category), fmt,                 \
+        (const double[]){ __VA_ARGS__ },                                    \
+        (int)(sizeof((const double[]){ __VA_ARGS__ }) / sizeof(double)))
+
+/* Starts the writer thread. Without threads (or if it can't start),
+   records are formatted and written immediately instead. */
+void logger_init(void);
+
+/* Writes out everything queued so far and stops the thread. */
+void logger_quit(void);
+
+/* Queues one record without formatting or blocking, and wakes the writer
+   if it sleeps. Lines are prefixed with the seconds since SDL_Init() at
+   the time of the call, e.g. "[12.345] ", since they are written later.
+   Drops the record when the queue is full or the category is over its rate limit;
+   the writer reports how many were lost. Safe to call from any thread. */
+void logger_write(SDL_LogPriority priority, int category, const char *fmt,
+    const double *args, int arg_count);
+
+#endif /* LOGGER_H */
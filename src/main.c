@@ -1,3 +1,4 @@
+#define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
@@ -14,13 +15,29 @@
 #include <SDL3_net/SDL_net.h>
 #endif
 
-#if defined(__EMSCRIPTEN__)
-#include <emscripten/emscripten.h>
-#endif
-
 #include <stdarg.h>
 #include <stdio.h>
 
+#include "atlas.h"
+#include "audiocache.h"
+#include "batch.h"
+#include "bench.h"
+#include "latch.h"
+#include "layer.h"
+#include "loader.h"
+#include "logger.h"
+#include "motion.h"
+#include "pointers.h"
+#include "profiler.h"
+#include "raster.h"
+#include "scene.h"
+#include "scheduler.h"
+#include "sound.h"
+#include "subsystems.h"
+#include "trace.h"
+#include "vfs.h"
+#include "voices.h"
+
 #define ARRAY_SIZE(ARR) ((sizeof(ARR)) / (sizeof(*(ARR))))
 
 static void show_important_message(int duration, const char *format, ...)
@@ -43,20 +60,50 @@ static void show_important_message(int duration, const char *format, ...)
 }
 
 /* ----------------------------
-   Minimal globals for WASM main loop
+   App state shared by the SDL_App* callbacks
    ---------------------------- */
+/* What draws the frames (--renderer=) */
+enum Backend
+{
+    BACKEND_RENDERER, /* SDL_Renderer through the quad batch */
+    BACKEND_RASTER,   /* software, see raster.h */
+};
+
 static SDL_Window *g_window = NULL;
-static SDL_Renderer *g_renderer = NULL;
+static enum Backend g_backend = BACKEND_RENDERER;
+static SDL_Renderer *g_renderer = NULL; /* only for BACKEND_RENDERER */
+static struct Raster g_raster;
+static bool g_rasterSimd = true;
+static int g_rasterThreads = 0; /* 0 = one per core */
+static const char *g_renderDriver = NULL; /* --renderer=<SDL driver> */
 #if defined(WITH_IMAGE)
-static SDL_Texture *g_imageTex = NULL;
+static struct Atlas g_atlas;
+static int g_crate = -1; /* atlas handle */
 #endif
 #if defined(WITH_TTF)
-static SDL_Texture *g_textTexture = NULL;
+static TTF_TextEngine *g_textEngine = NULL;
+static TTF_Text *g_text = NULL;
 static TTF_Font *g_font = NULL;
+static SDL_Surface *g_textSurface = NULL; /* the text, for the rasterizer */
 #endif
 #if defined(WITH_MIXER)
 static MIX_Mixer *g_mixer = NULL;
-static MIX_Audio *g_audio = NULL;
+static struct AudioCache g_audioCache;
+static struct Sound g_clickSound;
+static struct Sound g_music;
+static struct VoicePool g_voices;
+static int g_click = -1; /* voice pool sound id */
+static const char *g_musicPath = NULL;
+static Sint64 g_audioBudget = 0; /* 0 = default */
+
+/* Copies of the click that may overlap before the oldest is cut off */
+#define CLICK_VOICES 8
+
+/* Clicks asked for before the sound could play. They are played once it
+   can, unless they are so old they would sound out of sync. */
+#define QUEUED_CLICK_MAX_AGE_NS (250 * SDL_NS_PER_MS)
+static int g_queuedClicks = 0;
+static Uint64 g_queuedClickTime = 0;
 #endif
 
 static int g_width = 640;
@@ -64,8 +111,23 @@ static int g_height = 480;
 static int g_fullscreen = 0;
 static int g_foreground = 1;
 static int g_quit = 0;
-
-/* Keep your COLORS and locations structure identical to original */
+static bool g_animating = false;
+static struct Scheduler g_scheduler;
+static struct Profiler g_profiler;
+static const char *g_profileCsv = NULL;
+static struct Bench g_bench;
+static struct Batch g_batch;
+static struct Scene g_scene;
+static bool g_useScene = false; /* --scene, SDL_Renderer only */
+static struct Layer g_staticLayer; /* the crate and the text */
+static bool g_useLayers = true;    /* --no-layers draws them every frame */
+static const char *g_startupTrace = NULL; /* --startup-trace file */
+static bool g_started = false;  /* first complete frame shown */
+
+/* Quads per SDL_RenderGeometry call before the batch has to flush */
+#define BATCH_QUADS 4096
+
+/* Palette for pointer markers, assigned round-robin as pointers appear */
 static const SDL_Color COLORS[10] = {
     { 255, 0, 0, 255 },
     { 0, 255, 0, 255 },
@@ -79,12 +141,38 @@ static const SDL_Color COLORS[10] = {
     { 192, 192, 192, 255 },
 };
 
-struct Location
+static struct Vfs g_vfs;
+static struct Loader g_loader;
+static struct Subsystems g_subsystems;
+
+/* Loader tags */
+enum Asset
+{
+    ASSET_CRATE,
+    ASSET_CLICK,
+    ASSET_FONT,
+};
+
+static struct PointerTable g_pointers;
+
+/* --scene nodes, -1 until built */
+enum SceneLayer
 {
-    int valid;
-    SDL_FRect rect;
+    LAYER_STATIC,
+    LAYER_BENCH,
+    LAYER_POINTERS,
 };
-static struct Location g_locations[10];
+static int g_staticNode = -1; /* group for the crate and the text */
+static int g_crateNode = -1;
+static int g_textNode = -1;
+static int *g_benchNodes = NULL;
+static int g_benchNodeCount = 0;
+static int g_pointerNodes[POINTERS_MAX]; /* by dense index */
+static int g_pointerNodeCount = 0;
+static Sint64 g_sceneRedrawn = 0; /* pixels, for the bench summary */
+static Sint64 g_sceneShown = 0;
+static struct MotionQueue g_motion;
+static struct InputLatch g_latch;
 
 #ifdef SDL_PLATFORM_ANDROID
 #define RECT_W 250
@@ -92,772 +180,1432 @@ static struct Location g_locations[10];
 #define RECT_W 50
 #endif
 
-/* Forward declaration of the loop function used by Emscripten */
-#if defined(__EMSCRIPTEN__)
-static void main_loop(void *arg);
-#endif
-
-int main(int argc, char *argv[])
+static void pointer_down(enum PointerKind kind, Uint64 device, Uint64 id,
+    float x, float y)
 {
-    int linked_version;
-
-    (void)argc;
-    (void)argv;
-
-    linked_version = SDL_GetVersion();
-    SDL_Log("We compiled against SDL version %u.%u.%u ...\n", SDL_MAJOR_VERSION,
-        SDL_MINOR_VERSION, SDL_MICRO_VERSION);
-    SDL_Log("But we are linking against SDL version %u.%u.%u.\n",
-        SDL_VERSIONNUM_MAJOR(linked_version),
-        SDL_VERSIONNUM_MINOR(linked_version),
-        SDL_VERSIONNUM_MICRO(linked_version));
-
-    SDL_SetHint("SDL_MIXER_DISABLE_DRFLAC", "1");
-    SDL_SetHint("SDL_MIXER_DISABLE_DRMP3", "1");
+    const struct PointerKey key = { kind, device, id };
+    struct Pointer *p =
+        pointers_insert(&g_pointers, &key, (int)ARRAY_SIZE(COLORS));
+    if (p)
+    {
+        p->target.x = x - RECT_W / 2;
+        p->target.y = y - RECT_W / 2;
+        p->target.w = RECT_W;
+        p->target.h = RECT_W;
+        /* Snap instead of interpolating in from somewhere else */
+        p->rect = p->target;
+        p->prev = p->target;
+        scheduler_invalidate(&g_scheduler);
+    }
+}
 
-    // Disable mouse event synthesis from touch events
-    SDL_SetHint(SDL_HINT_TOUCH_MOUSE_EVENTS, "0");
-    SDL_SetHint(SDL_HINT_MOUSE_TOUCH_EVENTS, "0");
+static struct Pointer *pointer_move(enum PointerKind kind, Uint64 device,
+    Uint64 id, float x, float y)
+{
+    const struct PointerKey key = { kind, device, id };
+    struct Pointer *p = pointers_find(&g_pointers, &key);
+    if (p)
+    {
+        p->target.x = x - RECT_W / 2;
+        p->target.y = y - RECT_W / 2;
+        scheduler_invalidate(&g_scheduler);
+    }
+    return p;
+}
 
-    if (!SDL_Init(SDL_INIT_VIDEO))
+static void pointer_up(enum PointerKind kind, Uint64 device, Uint64 id)
+{
+    const struct PointerKey key = { kind, device, id };
+    if (pointers_remove(&g_pointers, &key))
     {
-        SDL_Log("SDL_Init failed (%s)", SDL_GetError());
-        return 1;
+        scheduler_invalidate(&g_scheduler);
     }
+}
 
-#if defined(WITH_IMAGE)
+static void play_click(void)
+{
+#if defined(WITH_MIXER)
+    if (g_click < 0)
     {
-        int v = IMG_Version();
-        SDL_Log("SDL3_image version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
-            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+        /* The device or the sound is still on its way */
+        g_queuedClicks = SDL_min(g_queuedClicks + 1, CLICK_VOICES);
+        g_queuedClickTime = SDL_GetTicksNS();
+        return;
+    }
+    if (!voices_play(&g_voices, g_click, 1.0f))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to play audio (%s)",
+            SDL_GetError());
     }
 #endif
+}
 
 #if defined(WITH_MIXER)
+static void play_queued_clicks(void)
+{
+    if (SDL_GetTicksNS() - g_queuedClickTime <= QUEUED_CLICK_MAX_AGE_NS)
     {
-        int v = MIX_Version();
-        SDL_Log("SDL3_mixer version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
-            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+        while (g_queuedClicks > 0)
+        {
+            g_queuedClicks--;
+            play_click();
+        }
     }
+    g_queuedClicks = 0;
+}
+#endif
 
-    if (!MIX_Init())
+#if defined(WITH_PAK)
+/* assets.pak sits next to the executable, or at the root of the web
+   build's file system. Loose files still work without it. */
+static void mount_archive(void)
+{
+    char path[512];
+    const char *base = SDL_GetBasePath();
+
+    SDL_snprintf(path, sizeof(path), "%sassets.pak", base ? base : "");
+    if (vfs_mount(&g_vfs, path))
     {
-        SDL_Log("MIX_Init failed (%s)", SDL_GetError());
-        return 1;
+        SDL_Log("Mounted %s, %d assets", path, (int)g_vfs.count);
     }
-
-    g_mixer = MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
-    if (g_mixer == NULL)
+    else
     {
-        SDL_Log("Couldn't create mixer: %s", SDL_GetError());
-        return 1;
+        SDL_Log("No asset archive, using loose files (%s)", SDL_GetError());
     }
+}
+#endif
 
+/* Finishes what needed the audio device or SDL_ttf, now they are up. Until
+   then the app runs silent and without text. */
+static void subsystems_ready(void)
+{
+#if defined(WITH_MIXER)
+    g_mixer = g_subsystems.mixer;
+    if (g_mixer)
     {
         SDL_AudioSpec mixerspec;
         MIX_GetMixerFormat(g_mixer, &mixerspec);
         SDL_Log("Mixer is format %s, %d channels, %d frequency",
             SDL_GetAudioFormatName(mixerspec.format), mixerspec.channels,
             mixerspec.freq);
-    }
 
-    SDL_Log("Available MIXER decoders:");
+        audio_cache_init(&g_audioCache, g_mixer, &g_vfs, g_audioBudget);
+        voices_init(&g_voices, g_mixer);
+        loader_load_audio(&g_loader, ASSET_CLICK, g_mixer,
+            "audio/picked-coin-echo-2.wav");
+    }
+    if (g_mixer && g_musicPath)
     {
-        const int num_decoders = MIX_GetNumAudioDecoders();
-        if (num_decoders < 0)
-        {
-            SDL_Log(" - [error (%s)]", SDL_GetError());
-        }
-        else if (num_decoders == 0)
+        /* Long files stream, short ones are cheaper predecoded */
+        if (sound_load(&g_music, &g_audioCache, g_musicPath, SOUND_AUTO, 0) &&
+            sound_play(&g_music, -1))
         {
-            SDL_Log(" - [none]");
+            SDL_Log("%s: %s", g_musicPath,
+                g_music.policy == SOUND_STREAM ? "streaming" : "predecoded");
         }
         else
         {
-            for (int i = 0; i < num_decoders; i++)
-            {
-                SDL_Log(" - %s", MIX_GetAudioDecoder(i));
-            }
+            SDL_Log("Failed to play '%s' (%s)", g_musicPath, SDL_GetError());
         }
     }
+#endif
 
-    // Enable debug logging
-    SDL_SetLogPriorities(SDL_LOG_PRIORITY_DEBUG);
-
-    const char *audiofname = NULL;
-
-#ifdef __ANDROID__
-    audiofname = "audio/picked-coin-echo-2.wav";
-#endif // __ANDROID__
-
-#ifdef __WIN32__
-    audiofname = "app/src/main/assets/audio/picked-coin-echo-2.wav";
-#endif // __WIN32__
-
-#ifdef __EMSCRIPTEN__
-    audiofname = "app/src/main/assets/audio/picked-coin-echo-2.wav";
-#endif // __EMSCRIPTEN__
-
-    if (audiofname)
+#if defined(WITH_TTF)
+    if (g_subsystems.ttf && g_renderer)
     {
-        g_audio = MIX_LoadAudio(g_mixer, audiofname, false);
-        if (g_audio == NULL)
-        {
-            SDL_Log("Failed to load '%s' (%s)", audiofname, SDL_GetError());
-        }
-        if (g_audio)
+        /* Glyphs are rasterized once into the engine's atlas; changing a
+           string afterwards only reshapes it */
+        const int span = trace_begin("text engine");
+        g_textEngine = TTF_CreateRendererTextEngine(g_renderer);
+        trace_end(span);
+        if (!g_textEngine)
         {
-            SDL_AudioSpec audiospec;
-            MIX_GetAudioFormat(g_audio, &audiospec);
-            SDL_Log("%s: %s, %d channel%s, %d freq", audiofname,
-                SDL_GetAudioFormatName(audiospec.format),
-                audiospec.channels, (audiospec.channels == 1) ? "" : "s",
-                audiospec.freq);
+            SDL_Log("TTF_CreateRendererTextEngine failed: %s", SDL_GetError());
         }
     }
+    if (g_subsystems.ttf && (g_textEngine || !g_renderer))
+    {
+#ifdef __ANDROID__
+        loader_load_font(&g_loader, ASSET_FONT, "fonts/arial.ttf", 120);
+#else
+        loader_load_font(&g_loader, ASSET_FONT, "fonts/arial.ttf", 70);
+#endif // __ANDROID__
+    }
 #endif
+}
 
-#if defined(WITH_NET)
+/* Startup ends with the first frame that has every asset in it */
+static void finish_startup(void)
+{
+    g_started = true;
+    trace_report();
+    if (!g_startupTrace)
     {
-        int v = NET_Version();
-        SDL_Log("SDL3_net version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
-            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+        return;
     }
-#endif
 
-    int width = 640;
-    int height = 480;
-    int flags = SDL_WINDOW_RESIZABLE;
+    char path[512];
 #if defined(SDL_PLATFORM_ANDROID)
-    flags |= SDL_WINDOW_FULLSCREEN;
+    /* Somewhere adb pull can reach */
+    SDL_snprintf(path, sizeof(path), "%s/%s",
+        SDL_GetAndroidExternalStoragePath(), g_startupTrace);
+#else
+    SDL_strlcpy(path, g_startupTrace, sizeof(path));
 #endif
+    if (trace_write(path))
+    {
+        SDL_Log("Startup trace written to %s", path);
+    }
+    else
+    {
+        SDL_Log("Couldn't write the startup trace (%s)", SDL_GetError());
+    }
+}
 
-    char title[32];
-
-    SDL_snprintf(title, sizeof(title), "An SDL %d.%d.%d window",
-        SDL_VERSIONNUM_MAJOR(linked_version),
-        SDL_VERSIONNUM_MINOR(linked_version),
-        SDL_VERSIONNUM_MICRO(linked_version));
-    g_window = SDL_CreateWindow(title, width, height, flags);
-
-    if (g_window == NULL)
+#if defined(WITH_TTF)
+/* The rasterizer has no text engine: the string is rendered once, in the
+   premultiplied ARGB8888 its blits take */
+static SDL_Surface *render_text_surface(TTF_Font *font, const char *text)
+{
+    const SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface *rendered = TTF_RenderText_Blended(font, text, 0, white);
+    if (!rendered)
     {
-        show_important_message(5, "Could not create window %s", SDL_GetError());
-        return 1;
+        SDL_Log("TTF_RenderText_Blended failed: %s", SDL_GetError());
+        return NULL;
     }
-    SDL_Log("Window created!");
 
-    g_renderer = SDL_CreateRenderer(g_window, NULL);
-    if (g_renderer == NULL)
+    SDL_Surface *surface =
+        SDL_ConvertSurface(rendered, SDL_PIXELFORMAT_ARGB8888);
+    SDL_DestroySurface(rendered);
+    if (surface && !SDL_PremultiplySurfaceAlpha(surface, false))
     {
-        show_important_message(5, "Could not create renderer: %s",
-            SDL_GetError());
-        return 1;
+        SDL_DestroySurface(surface);
+        surface = NULL;
     }
-    SDL_Log("Renderer created!");
+    return surface;
+}
+#endif
 
 #if defined(WITH_IMAGE)
+/* Sends what the atlas has waiting to the GPU, as far as budget goes. The
+   rasterizer draws from the CPU pages and has nothing to upload. */
+static void upload_atlas(Sint64 *budget)
+{
+    if (g_backend == BACKEND_RASTER || !atlas_pending(&g_atlas))
+    {
+        return;
+    }
 
-    const char *imagefname = NULL;
-
-#ifdef __ANDROID__
-    imagefname = "sprites/crate.png";
-#endif // __ANDROID__
+    const int span = trace_begin("atlas upload");
+    atlas_upload(&g_atlas, budget);
+    trace_end(span);
+    /* Images become drawable once all of them is up */
+    layer_invalidate(&g_staticLayer);
+    scheduler_invalidate(&g_scheduler);
+}
+#endif
 
-#ifdef __WIN32__
-    imagefname = "app/src/main/assets/sprites/crate.png";
-#endif // __WIN32__
+/* Whether receive_assets() has anything to do */
+static bool assets_pending(void)
+{
+#if defined(WITH_IMAGE)
+    if (g_backend != BACKEND_RASTER && atlas_pending(&g_atlas))
+    {
+        return true;
+    }
+#endif
+    return loader_outstanding(&g_loader) > 0;
+}
 
-#ifdef __EMSCRIPTEN__
-    imagefname = "app/src/main/assets/sprites/crate.png";
-#endif // __EMSCRIPTEN__
+/* Takes loads finished by the worker pool and turns them into textures,
+   sounds and text. budget covers both the surfaces taken and the bytes
+   uploaded; atlas areas it doesn't pay for are uploaded on later calls,
+   leftovers first. */
+static void receive_assets(Sint64 budget)
+{
+    struct LoaderJob *job;
+    bool received = false;
 
-    if (imagefname)
+#if defined(WITH_IMAGE)
+    upload_atlas(&budget);
+#endif
+    while ((job = loader_poll(&g_loader, &budget)) != NULL)
     {
-        g_imageTex = IMG_LoadTexture(g_renderer, imagefname);
-        if (!g_imageTex)
+        received = true;
+        if (!job->ok)
         {
-            SDL_Log("Failed to load %s: %s", imagefname, SDL_GetError());
+            SDL_Log("Failed to load %s: %s", job->path, job->error);
         }
-        else
+
+        switch (job->tag)
         {
-            SDL_Log("Image loaded successfully!");
-        }
-    }
+#if defined(WITH_IMAGE)
+            case ASSET_CRATE:
+                if (job->surface)
+                {
+                    const int span = trace_begin("atlas add");
+                    g_crate = atlas_add_surface(&g_atlas, job->surface);
+                    trace_end(span);
+                    SDL_DestroySurface(job->surface);
+                    if (g_crate >= 0)
+                    {
+                        SDL_Log("Image loaded successfully!");
+                    }
+                }
+                break;
+#endif
+#if defined(WITH_MIXER)
+            case ASSET_CLICK:
+                if (job->audio)
+                {
+                    /* Effects are always predecoded, the voice pool plays
+                       them. The cache takes the PCM the worker decoded. */
+                    audio_cache_adopt(&g_audioCache, job->path, job->audio);
+                    if (sound_load(&g_clickSound, &g_audioCache, job->path,
+                            SOUND_PREDECODE, 0))
+                    {
+                        SDL_AudioSpec audiospec;
+                        MIX_GetAudioFormat(g_clickSound.audio, &audiospec);
+                        SDL_Log("%s: %s, %d channel%s, %d freq", job->path,
+                            SDL_GetAudioFormatName(audiospec.format),
+                            audiospec.channels,
+                            (audiospec.channels == 1) ? "" : "s",
+                            audiospec.freq);
+                        g_click = voices_add_sound(&g_voices,
+                            g_clickSound.audio, CLICK_VOICES);
+                        play_queued_clicks();
+                    }
+                }
+                break;
 #endif
-
 #if defined(WITH_TTF)
-    SDL_Log("WITH_TTF");
-    if (!TTF_Init())
-    {
-        SDL_Log("TTF_Init failed: %s", SDL_GetError());
-        return 1;
+            case ASSET_FONT:
+                if (job->font)
+                {
+                    const int span = trace_begin("text");
+                    g_font = job->font;
+                    if (!g_renderer)
+                    {
+                        g_textSurface =
+                            render_text_surface(g_font, "Hello World!");
+                    }
+                    else
+                    {
+                        g_text = TTF_CreateText(g_textEngine, g_font,
+                            "Hello World!", 0);
+                        profiler_set_font(&g_profiler, g_textEngine, g_font);
+                    }
+                    trace_end(span);
+                }
+                break;
+#endif
+            default:
+                break;
+        }
+        loader_free_job(job);
     }
 
-    const char *fontfname = NULL;
-
-#ifdef __ANDROID__
-    fontfname = "fonts/arial.ttf";
-#endif // __ANDROID__
-
-#ifdef __WIN32__
-    fontfname = "app/src/main/assets/fonts/arial.ttf";
-#endif // __WIN32__
-
-#ifdef __EMSCRIPTEN__
-    fontfname = "app/src/main/assets/fonts/arial.ttf";
-#endif // __EMSCRIPTEN__
-
-#ifdef __ANDROID__
-    g_font = TTF_OpenFont(fontfname, 120);
-#endif // __ANDROID__
-
-#ifdef __WIN32__
-    g_font = TTF_OpenFont(fontfname, 70);
-#endif // __WIN32__
-
-#ifdef __EMSCRIPTEN__
-    g_font = TTF_OpenFont(fontfname, 70);
-#endif // __EMSCRIPTEN__
-
-    if (!g_font)
+    if (received)
     {
-        SDL_Log("Failed to open font: %s", SDL_GetError());
-        return 1;
+#if defined(WITH_IMAGE)
+        upload_atlas(&budget);
+#endif
+        layer_invalidate(&g_staticLayer);
+        scheduler_invalidate(&g_scheduler);
     }
+}
 
+/* Hands each pointer's latest coalesced position to pointer_move(). With
+   snap, the pointer jumps there instead of being interpolated towards it
+   over the next simulation step. */
+static void flush_motion(bool snap)
+{
+    for (int i = 0; i < g_motion.pending_count; i++)
     {
-        SDL_Color white = { 255, 255, 255, 255 };
-        SDL_Surface *textSurface =
-            TTF_RenderText_Blended(g_font, "Hello World!", 12, white);
-        if (!textSurface)
+        const struct MotionPending *m = &g_motion.pending[i];
+        LOG_DEBUG(SDL_LOG_CATEGORY_APPLICATION,
+            "pointer move: kind=%d id=%d, [%g, %g], %d samples",
+            m->last.key.kind, m->last.key.id, m->last.x, m->last.y,
+            m->samples);
+        struct Pointer *p = pointer_move(m->last.key.kind,
+            m->last.key.device, m->last.key.id, m->last.x, m->last.y);
+        if (p && snap)
         {
-            SDL_Log("TTF_RenderText_Blended failed: %s", SDL_GetError());
-            return 1;
+            p->rect = p->target;
+            p->prev = p->target;
         }
-
-        g_textTexture = SDL_CreateTextureFromSurface(g_renderer, textSurface);
-        SDL_DestroySurface(textSurface);
     }
-#endif
+    motion_clear_pending(&g_motion);
+}
+
+/* Motion events stop here and reach the handlers once per frame. Returns
+   false for every other event, which must flush the pending motion before
+   being handled so a press or release never overtakes a move. */
+static bool coalesce_motion(const SDL_Event *event)
+{
+    struct MotionSample sample;
 
-    /* initialize locations exactly like your original loop did */
-    for (size_t i = 0; i < ARRAY_SIZE(g_locations); i++)
+    switch (event->type)
+    {
+#if !defined(SDL_PLATFORM_ANDROID)
+        case SDL_EVENT_MOUSE_MOTION:
+            sample.key.kind = POINTER_MOUSE;
+            sample.key.device = event->motion.which;
+            sample.key.id = 0;
+            sample.x = event->motion.x;
+            sample.y = event->motion.y;
+            break;
+#endif
+        case SDL_EVENT_FINGER_MOTION:
+            sample.key.kind = POINTER_FINGER;
+            sample.key.device = event->tfinger.touchID;
+            sample.key.id = event->tfinger.fingerID;
+            sample.x = g_width * event->tfinger.x;
+            sample.y = g_height * event->tfinger.y;
+            break;
+        case SDL_EVENT_PEN_MOTION:
+            sample.key.kind = POINTER_PEN;
+            sample.key.device = event->pmotion.which;
+            sample.key.id = 0;
+            sample.x = event->pmotion.x;
+            sample.y = event->pmotion.y;
+            break;
+        default:
+            return false;
+    }
+    if (g_latch.enabled)
     {
-        g_locations[i].valid = 0;
-        g_locations[i].rect.w = RECT_W;
-        g_locations[i].rect.h = RECT_W;
+        /* Already captured by the latch's event watch */
+        return true;
     }
+    sample.timestamp = event->common.timestamp;
 
-    show_important_message(1, "Entering the loop");
+    if (!motion_push(&g_motion, &sample))
+    {
+        flush_motion(false);
+        motion_push(&g_motion, &sample);
+    }
+    return true;
+}
 
-    /* copy width/height into globals used by main_loop if Emscripten */
-    g_width = width;
-    g_height = height;
-    g_fullscreen = 0;
-    g_foreground = 1;
-    g_quit = 0;
+static void handle_event(const SDL_Event *event)
+{
+    if (event->type == g_loader.wake_event ||
+        event->type == g_subsystems.ready_event)
+    {
+        /* An asset or subsystem is ready; pick it up next iteration */
+        scheduler_invalidate(&g_scheduler);
+        return;
+    }
 
-#if defined(__EMSCRIPTEN__)
-    /* On WebAssembly we hand control to Emscripten's main loop */
-    emscripten_set_main_loop_arg(main_loop, NULL, 0, 1);
-    /* When the page is closed / program quits, Emscripten will return control
-       as needed. We don't reach the cleanup code here in typical single-page
-       apps until we call emscripten_cancel_main_loop(), so we'll provide a
-       small cleanup path inside main_loop when g_quit becomes true. */
-#else
-    /* Original blocking loop for native targets */
-    while (!g_quit)
+    switch (event->type)
     {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
-        {
-            switch (event.type)
+        case SDL_EVENT_QUIT:
+            g_quit = 1;
+            break;
+        case SDL_EVENT_DISPLAY_ORIENTATION:
+            switch (event->display.data1)
             {
-                case SDL_EVENT_QUIT:
-                    g_quit = 1;
-                    break;
-                case SDL_EVENT_DISPLAY_ORIENTATION:
-                    switch (event.display.data1)
-                    {
-                        case SDL_ORIENTATION_LANDSCAPE:
-                            show_important_message(1, "landscape");
-                            break;
-                        case SDL_ORIENTATION_LANDSCAPE_FLIPPED:
-                            show_important_message(1, "landscape (flipped)");
-                            break;
-                        case SDL_ORIENTATION_PORTRAIT:
-                            show_important_message(1, "portrait");
-                            break;
-                        case SDL_ORIENTATION_PORTRAIT_FLIPPED:
-                            show_important_message(1, "portrait (flipped)");
-                            break;
-                    }
+                case SDL_ORIENTATION_LANDSCAPE:
+                    show_important_message(1, "landscape");
                     break;
-                case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
-                    width = event.window.data1;
-                    height = event.window.data2;
-                    g_width = width;
-                    g_height = height;
+                case SDL_ORIENTATION_LANDSCAPE_FLIPPED:
+                    show_important_message(1, "landscape (flipped)");
                     break;
-                case SDL_EVENT_WINDOW_SHOWN:
-                    g_foreground = 1;
+                case SDL_ORIENTATION_PORTRAIT:
+                    show_important_message(1, "portrait");
                     break;
-                case SDL_EVENT_WINDOW_HIDDEN:
-                    g_foreground = 0;
+                case SDL_ORIENTATION_PORTRAIT_FLIPPED:
+                    show_important_message(1, "portrait (flipped)");
                     break;
+            }
+            break;
+        case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            g_width = event->window.data1;
+            g_height = event->window.data2;
+            scheduler_invalidate(&g_scheduler);
+            break;
+        case SDL_EVENT_WINDOW_EXPOSED:
+            scheduler_invalidate(&g_scheduler);
+            break;
+        case SDL_EVENT_RENDER_TARGETS_RESET:
+        case SDL_EVENT_RENDER_DEVICE_RESET:
+            /* The scene's and the layer's textures lost their pixels */
+            scene_invalidate(&g_scene);
+            layer_invalidate(&g_staticLayer);
+            scheduler_invalidate(&g_scheduler);
+            break;
+        case SDL_EVENT_WINDOW_SHOWN:
+            g_foreground = 1;
+            scheduler_invalidate(&g_scheduler);
+            break;
+        case SDL_EVENT_WINDOW_HIDDEN:
+            g_foreground = 0;
+            break;
 #if !defined(SDL_PLATFORM_ANDROID)
-                case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "mouse button down: which=%d, [%g, %g]",
-                        event.button.which, event.button.x,
-                        event.button.y);
-                    if (event.button.which < ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.button.which].valid = 1;
-                        g_locations[event.button.which].rect.x =
-                            event.button.x - RECT_W / 2;
-                        g_locations[event.button.which].rect.y =
-                            event.button.y - RECT_W / 2;
-                    }
-#if defined(WITH_MIXER)
-                    if (g_audio != NULL && !MIX_PlayAudio(g_mixer, g_audio))
-                    {
-                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                            "Failed to play audio (%s)", SDL_GetError());
-                    }
-#endif
-                    break;
-                case SDL_EVENT_MOUSE_BUTTON_UP:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "mouse button up: which=%d, [%g, %g]",
-                        event.button.which, event.button.x,
-                        event.button.y);
-                    if (event.button.which < ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.button.which].valid = 0;
-                    }
-                    break;
-                case SDL_EVENT_MOUSE_MOTION:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "mouse move: button=%d", event.motion.which);
-                    if (event.button.which < ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.button.which].rect.x =
-                            event.motion.x - RECT_W / 2;
-                        g_locations[event.button.which].rect.y =
-                            event.motion.y - RECT_W / 2;
-                    }
-                    break;
-                case SDL_EVENT_WILL_ENTER_BACKGROUND:
-                    g_foreground = 0;
-                    break;
-                case SDL_EVENT_DID_ENTER_FOREGROUND:
-                    g_foreground = 1;
-                    break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            LOG_DEBUG(SDL_LOG_CATEGORY_APPLICATION,
+                "mouse button down: which=%d, [%g, %g]", event->button.which,
+                event->button.x, event->button.y);
+            pointer_down(POINTER_MOUSE, event->button.which, 0, event->button.x,
+                event->button.y);
+            play_click();
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            LOG_DEBUG(SDL_LOG_CATEGORY_APPLICATION,
+                "mouse button up: which=%d, [%g, %g]", event->button.which,
+                event->button.x, event->button.y);
+            pointer_up(POINTER_MOUSE, event->button.which, 0);
+            break;
+        case SDL_EVENT_WILL_ENTER_BACKGROUND:
+            g_foreground = 0;
+            break;
+        case SDL_EVENT_DID_ENTER_FOREGROUND:
+            g_foreground = 1;
+            scheduler_invalidate(&g_scheduler);
+            break;
 #endif
-#if defined(SDL_PLATFORM_ANDROID)
-                case SDL_EVENT_FINGER_DOWN:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "finger down: fingerID=%d, [%f, %f]",
-                        (int)event.tfinger.fingerID, event.tfinger.x,
-                        event.tfinger.y);
-                    if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.tfinger.fingerID].valid = 1;
-                        g_locations[event.tfinger.fingerID].rect.x =
-                            g_width * event.tfinger.x - RECT_W / 2;
-                        g_locations[event.tfinger.fingerID].rect.y =
-                            g_height * event.tfinger.y - RECT_W / 2;
-                    }
-
-#if defined(WITH_MIXER)
-                    // Play the sound effect
-                    MIX_PlayAudio(g_mixer, g_audio);
+        case SDL_EVENT_FINGER_DOWN:
+            LOG_DEBUG(SDL_LOG_CATEGORY_APPLICATION,
+                "finger down: fingerID=%d, [%f, %f]",
+                (int)event->tfinger.fingerID, event->tfinger.x,
+                event->tfinger.y);
+            pointer_down(POINTER_FINGER, event->tfinger.touchID,
+                event->tfinger.fingerID, g_width * event->tfinger.x,
+                g_height * event->tfinger.y);
+            play_click();
+            break;
+        case SDL_EVENT_FINGER_UP:
+            LOG_DEBUG(SDL_LOG_CATEGORY_APPLICATION,
+                "finger up: fingerID=%d, [%f, %f]",
+                (int)event->tfinger.fingerID, event->tfinger.x,
+                event->tfinger.y);
+            pointer_up(POINTER_FINGER, event->tfinger.touchID,
+                event->tfinger.fingerID);
+            break;
+        case SDL_EVENT_PEN_DOWN:
+            pointer_down(POINTER_PEN, event->ptouch.which, 0, event->ptouch.x,
+                event->ptouch.y);
+            break;
+        case SDL_EVENT_PEN_UP:
+            pointer_up(POINTER_PEN, event->ptouch.which, 0);
+            break;
+#if defined(SDL_PLATFORM_ANDROID) || defined(SDL_PLATFORM_EMSCRIPTEN)
+        case SDL_EVENT_TERMINATING:
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
+                "Received SDL_EVENT_TERMINATING");
+            g_quit = 1;
+            break;
 #endif
-
-                    break;
-                case SDL_EVENT_FINGER_UP:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "finger up: fingerID=%d, [%f, %f]",
-                        (int)event.tfinger.fingerID, event.tfinger.x,
-                        event.tfinger.y);
-                    if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.tfinger.fingerID].valid = 0;
-                    }
-                    break;
-                case SDL_EVENT_FINGER_MOTION:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "finger move: button=%d", event.motion.which);
-                    if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                    {
-                        g_locations[event.tfinger.fingerID].rect.x =
-                            g_width * event.tfinger.x - RECT_W / 2;
-                        g_locations[event.tfinger.fingerID].rect.y =
-                            g_height * event.tfinger.y - RECT_W / 2;
-                    }
-                    break;
-                case SDL_EVENT_TERMINATING:
-                    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                        "Received SDL_EVENT_TERMINATING");
+        case SDL_EVENT_KEY_UP:
+            switch (event->key.key)
+            {
+                case SDLK_ESCAPE:
                     g_quit = 1;
                     break;
-#endif // SDL_PLATFORM_ANDROID || SDL_PLATFORM_EMSCRIPTEN
-                case SDL_EVENT_KEY_UP:
-                    switch (event.key.key)
+                case SDLK_RETURN:
+                    if (event->key.mod & SDL_KMOD_ALT)
                     {
-                        case SDLK_ESCAPE:
-                            g_quit = 1;
-                            break;
-                        case SDLK_RETURN:
-                            if (event.key.mod & SDL_KMOD_ALT)
-                            {
-                                g_fullscreen = !g_fullscreen;
-                                SDL_SetWindowFullscreen(g_window, g_fullscreen);
-                            }
-                            break;
+                        g_fullscreen = !g_fullscreen;
+                        SDL_SetWindowFullscreen(g_window, g_fullscreen);
                     }
                     break;
+                case SDLK_F3:
+                    g_profiler.overlay = !g_profiler.overlay;
+                    scheduler_invalidate(&g_scheduler);
+                    break;
             }
-        }
-        if (g_foreground)
-        {
-            SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
-            SDL_RenderClear(g_renderer);
+            break;
+    }
+}
 
-#if defined(WITH_IMAGE)
+/* One fixed simulation step. Returns true while anything visible is still
+   moving, i.e. the interpolated positions differ between frames. */
+static bool update(void)
+{
+    bool moving = false;
 
-#ifdef __ANDROID__
-            if (g_imageTex)
-            {
-                SDL_FRect dst = { 50, 50, 512, 512 };
-                SDL_RenderTexture(g_renderer, g_imageTex, NULL, &dst);
-            }
-#endif // __ANDROID__
+    for (int i = 0; i < g_pointers.count; i++)
+    {
+        struct Pointer *p = &g_pointers.dense[i];
+        p->prev = p->rect;
+        p->rect = p->target;
+        if (p->prev.x != p->rect.x || p->prev.y != p->rect.y)
+        {
+            moving = true;
+        }
+    }
+    return moving;
+}
 
-#ifdef __WIN32__
-            if (g_imageTex)
-            {
-                SDL_FRect dst = { 50, 50, 128, 128 };
-                SDL_RenderTexture(g_renderer, g_imageTex, NULL, &dst);
-            }
-#endif // __WIN32__
+/* Where the static content goes */
+#if defined(WITH_IMAGE)
+#ifdef __ANDROID__
+static const SDL_FRect CRATE_RECT = { 50, 50, 512, 512 };
+#else
+static const SDL_FRect CRATE_RECT = { 50, 50, 128, 128 };
+#endif
+#endif
+#if defined(WITH_TTF)
+#ifdef __ANDROID__
+static const SDL_FPoint TEXT_POS = { 700.0f, 100.0f };
+#else
+static const SDL_FPoint TEXT_POS = { 200.0f, 50.0f };
+#endif
+#endif
 
+static SDL_FColor pointer_color(const struct Pointer *p)
+{
+    const SDL_Color c = COLORS[p->color];
+    return (SDL_FColor){ c.r / 255.0f, c.g / 255.0f, c.b / 255.0f,
+        c.a / 255.0f };
+}
+
+/* Pointer position between the last two simulation steps */
+static SDL_FRect pointer_rect(const struct Pointer *p, float alpha)
+{
+    SDL_FRect rect = p->rect;
+    rect.x = p->prev.x + (p->rect.x - p->prev.x) * alpha;
+    rect.y = p->prev.y + (p->rect.y - p->prev.y) * alpha;
+    return rect;
+}
+
+static void draw_fill_rect(const SDL_FRect *rect, SDL_FColor color,
+    SDL_BlendMode blend)
+{
+    switch (g_backend)
+    {
+        case BACKEND_RASTER:
+            raster_fill_rect(&g_raster, rect, color, blend);
+            break;
+        default:
+            batch_fill_rect(&g_batch, rect, color, blend);
+            break;
+    }
+}
+
+#if defined(WITH_IMAGE)
+static void draw_sprite(int handle, const SDL_FRect *dst)
+{
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    if (g_backend == BACKEND_RASTER)
+    {
+        SDL_Surface *page;
+        SDL_Rect src;
+        if (atlas_get_surface(&g_atlas, handle, &page, &src))
+        {
+            raster_blit(&g_raster, page, &src, dst, white);
+        }
+        return;
+    }
+
+    SDL_Texture *page;
+    SDL_FRect src;
+    if (atlas_get(&g_atlas, handle, &page, &src))
+    {
+        batch_texture(&g_batch, page, &src, dst, white);
+    }
+}
 #endif
 
 #if defined(WITH_TTF)
-            if (g_textTexture)
-            {
-                float tw, th;
-                SDL_GetTextureSize(g_textTexture, &tw, &th);
+static void draw_text(float x, float y)
+{
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-#ifdef __ANDROID__
-                SDL_FRect dst = { 700.0f, 100.0f, tw, th };
-#endif // __ANDROID__
+    if (g_text)
+    {
+        /* The text engine draws straight to the renderer from its own glyph
+           atlas, so keep the sprites queued so far underneath it */
+        batch_flush(&g_batch);
+        TTF_DrawRendererText(g_text, x, y);
+        return;
+    }
+    if (!g_textSurface)
+    {
+        return;
+    }
 
-#ifdef __WIN32__
-                SDL_FRect dst = { 200.0f, 50.0f, tw, th };
-#endif // __WIN32__
+    const SDL_FRect dst = { x, y, (float)g_textSurface->w,
+        (float)g_textSurface->h };
+    if (g_backend == BACKEND_RASTER)
+    {
+        raster_blit(&g_raster, g_textSurface, NULL, &dst, white);
+    }
+}
+#endif
 
-                SDL_RenderTexture(g_renderer, g_textTexture, NULL, &dst);
-            }
+/* --bench-quads: many sprites, to compare how the backends scale */
+static void draw_bench_quads(void)
+{
+    SDL_FRect rect;
+
+    for (int i = 0; i < g_bench.quad_count; i++)
+    {
+        bench_quad(&g_bench, i, g_width, g_height, &rect);
+#if defined(WITH_IMAGE)
+        draw_sprite(g_crate, &rect);
+#else
+        draw_fill_rect(&rect, (SDL_FColor){ 1.0f, 1.0f, 1.0f, 0.5f },
+            SDL_BLENDMODE_BLEND);
+#endif
+    }
+}
+
+/* The crate and the text, moved by dx, dy */
+static void draw_static(float dx, float dy)
+{
+#if defined(WITH_IMAGE)
+    SDL_FRect crate = CRATE_RECT;
+    crate.x += dx;
+    crate.y += dy;
+    draw_sprite(g_crate, &crate);
+#endif
+#if defined(WITH_TTF)
+    draw_text(TEXT_POS.x + dx, TEXT_POS.y + dy);
+#endif
+    (void)dx;
+    (void)dy;
+}
+
+/* What draw_static() covers with a renderer, empty until loaded */
+static SDL_FRect static_area(void)
+{
+    SDL_FRect area = { 0.0f, 0.0f, 0.0f, 0.0f };
+#if defined(WITH_IMAGE)
+    if (g_crate >= 0)
+    {
+        area = CRATE_RECT;
+    }
+#endif
+#if defined(WITH_TTF)
+    int w, h;
+    if (g_text && TTF_GetTextSize(g_text, &w, &h))
+    {
+        const SDL_FRect text = { TEXT_POS.x, TEXT_POS.y, (float)w, (float)h };
+        SDL_GetRectUnionFloat(&area, &text, &area);
+    }
 #endif
+    return area;
+}
 
-            for (size_t i = 0; i < ARRAY_SIZE(g_locations); i++)
+/* draw_static() through g_staticLayer: redrawn into it only when an asset
+   arrived or the window was resized, otherwise one cached quad */
+static void draw_static_layer(void)
+{
+    const SDL_FRect area = static_area();
+    if (layer_begin(&g_staticLayer, &area))
+    {
+        draw_static(-(float)g_staticLayer.area.x,
+            -(float)g_staticLayer.area.y);
+        layer_end(&g_staticLayer);
+    }
+    if (!layer_draw(&g_staticLayer))
+    {
+        draw_static(0.0f, 0.0f);
+    }
+}
+
+/* Creates the --scene nodes. Their content is filled in as it arrives. */
+static bool build_scene(void)
+{
+    g_staticNode = scene_add(&g_scene, -1);
+    g_crateNode = scene_add(&g_scene, g_staticNode);
+    g_textNode = scene_add(&g_scene, g_staticNode);
+    if (g_staticNode < 0 || g_crateNode < 0 || g_textNode < 0)
+    {
+        return false;
+    }
+    /* z is per node, the group only moves them */
+    scene_set_z(&g_scene, g_crateNode, LAYER_STATIC);
+    scene_set_z(&g_scene, g_textNode, LAYER_STATIC);
+
+    if (g_bench.quad_count > 0)
+    {
+        g_benchNodes =
+            (int *)SDL_malloc((size_t)g_bench.quad_count * sizeof(int));
+        if (!g_benchNodes)
+        {
+            return false;
+        }
+        for (; g_benchNodeCount < g_bench.quad_count; g_benchNodeCount++)
+        {
+            const int node = scene_add(&g_scene, -1);
+            if (node < 0)
             {
-                if (g_locations[i].valid)
-                {
-                    SDL_SetRenderDrawColor(g_renderer, COLORS[i].r, COLORS[i].g,
-                        COLORS[i].b, COLORS[i].a);
-                    SDL_RenderFillRect(g_renderer, &g_locations[i].rect);
-                }
+                return false;
             }
-            SDL_RenderPresent(g_renderer);
+            scene_set_z(&g_scene, node, LAYER_BENCH);
+            g_benchNodes[g_benchNodeCount] = node;
         }
-        SDL_Delay(10);
     }
-#endif /* !__EMSCRIPTEN__ */
-
-    /* Cleanup for native; for Emscripten, cleanup may be invoked from main_loop
-     */
-#if !defined(__EMSCRIPTEN__)
-    SDL_DestroyRenderer(g_renderer);
-    SDL_DestroyWindow(g_window);
+    return true;
+}
 
+/* Points node at an atlas image; false while it isn't loaded */
+static bool set_sprite_node(int node, int handle)
+{
 #if defined(WITH_IMAGE)
-    if (g_imageTex)
-        SDL_DestroyTexture(g_imageTex);
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    SDL_Texture *page;
+    SDL_FRect src;
+    if (atlas_get(&g_atlas, handle, &page, &src))
+    {
+        scene_set_texture(&g_scene, node, page, &src, white);
+        return true;
+    }
+#else
+    (void)node;
+    (void)handle;
 #endif
+    return false;
+}
 
 #if defined(WITH_TTF)
-    if (g_textTexture)
-        SDL_DestroyTexture(g_textTexture);
-    if (g_font)
-        TTF_CloseFont(g_font);
-    TTF_Quit();
+static void draw_scene_text(void *userdata, const SDL_FRect *rect)
+{
+    TTF_DrawRendererText((TTF_Text *)userdata, rect->x, rect->y);
+}
 #endif
 
-#if defined(WITH_MIXER)
-    if (g_audio)
-        MIX_DestroyAudio(g_audio);
-    if (g_mixer)
-        MIX_DestroyMixer(g_mixer);
-    MIX_Quit();
+/* render() with --scene: each node is set to what render() would draw
+   this frame, and the scene redraws only what that changed */
+static void render_scene(float alpha)
+{
+    const SDL_FColor black = { 0.0f, 0.0f, 0.0f, 1.0f };
+    SDL_FRect rect;
+    int sprite = -1;
+
+#if defined(WITH_IMAGE)
+    sprite = g_crate;
+    if (set_sprite_node(g_crateNode, g_crate))
+    {
+        scene_set_rect(&g_scene, g_crateNode, &CRATE_RECT);
+    }
 #endif
-    SDL_Quit();
-    return 0;
-#else
-    /* For Emscripten builds we return here and let the browser drive the app.
-       Actual cleanup happens when g_quit is set (see main_loop). */
-    return 0;
+#if defined(WITH_TTF)
+    int w, h;
+    if (g_text && TTF_GetTextSize(g_text, &w, &h))
+    {
+        rect = (SDL_FRect){ TEXT_POS.x, TEXT_POS.y, (float)w, (float)h };
+        scene_set_rect(&g_scene, g_textNode, &rect);
+        scene_set_custom(&g_scene, g_textNode, draw_scene_text, g_text);
+    }
 #endif
+
+    for (int i = 0; i < g_benchNodeCount; i++)
+    {
+        const int node = g_benchNodes[i];
+        bench_quad(&g_bench, i, g_width, g_height, &rect);
+        scene_set_rect(&g_scene, node, &rect);
+#if !defined(WITH_IMAGE)
+        scene_set_fill(&g_scene, node, (SDL_FColor){ 1.0f, 1.0f, 1.0f, 0.5f },
+            SDL_BLENDMODE_BLEND);
+#endif
+        set_sprite_node(node, sprite);
+    }
+
+    /* Pointer nodes are reused by dense index and hidden when unused */
+    for (int i = 0; i < g_pointers.count; i++)
+    {
+        const struct Pointer *p = &g_pointers.dense[i];
+        if (i == g_pointerNodeCount)
+        {
+            const int node = scene_add(&g_scene, -1);
+            if (node < 0)
+            {
+                break;
+            }
+            scene_set_z(&g_scene, node, LAYER_POINTERS);
+            g_pointerNodes[g_pointerNodeCount++] = node;
+        }
+        rect = pointer_rect(p, alpha);
+        scene_set_rect(&g_scene, g_pointerNodes[i], &rect);
+        scene_set_fill(&g_scene, g_pointerNodes[i], pointer_color(p),
+            SDL_BLENDMODE_NONE);
+        scene_set_visible(&g_scene, g_pointerNodes[i], true);
+    }
+    for (int i = g_pointers.count; i < g_pointerNodeCount; i++)
+    {
+        scene_set_visible(&g_scene, g_pointerNodes[i], false);
+    }
+
+    scene_render(&g_scene, black);
+    g_sceneRedrawn += g_scene.redrawn;
+    g_sceneShown += (Sint64)g_width * g_height;
 }
 
-/* The loop body extracted so Emscripten can call it. It mirrors the original
-   loop body. It uses the globals defined above. */
-#if defined(__EMSCRIPTEN__)
-static void main_loop(void *arg)
+/* Draws the scene, blending simulation states by alpha in [0, 1). With a
+   renderer everything goes through the quad batch: one SDL_RenderGeometry
+   call per texture run instead of one draw call per sprite and rect, and
+   the static content is a cached layer. Otherwise the rasterizer records
+   the same draws. The caller presents. */
+static void render(float alpha)
 {
-    (void)arg;
+    const SDL_FColor black = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    if (g_useScene)
+    {
+        render_scene(alpha);
+        return;
+    }
+
+    switch (g_backend)
+    {
+        case BACKEND_RASTER:
+            raster_begin(&g_raster, black);
+            break;
+        default:
+            SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+            SDL_RenderClear(g_renderer);
+            break;
+    }
+
+    if (g_staticLayer.renderer)
+    {
+        draw_static_layer();
+    }
+    else
+    {
+        draw_static(0.0f, 0.0f);
+    }
+
+    if (g_bench.enabled)
+    {
+        draw_bench_quads();
+    }
 
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+    for (int i = 0; i < g_pointers.count; i++)
     {
-        switch (event.type)
+        const struct Pointer *p = &g_pointers.dense[i];
+        const SDL_FRect rect = pointer_rect(p, alpha);
+        draw_fill_rect(&rect, pointer_color(p), SDL_BLENDMODE_NONE);
+    }
+    if (g_backend == BACKEND_RENDERER)
+    {
+        batch_flush(&g_batch);
+    }
+}
+
+SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
+{
+    int linked_version;
+    enum SchedulerPacing pacing = SCHEDULER_PACING_VSYNC;
+    double target_fps = 60.0;
+    double sim_hz = 60.0;
+    bool late_latch = false;
+
+    (void)appstate;
+
+    trace_init();
+    logger_init();
+    profiler_init(&g_profiler);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (bench_parse_arg(&g_bench, argv[i]))
         {
-            case SDL_EVENT_QUIT:
-                g_quit = 1;
-                break;
-            case SDL_EVENT_DISPLAY_ORIENTATION:
-                switch (event.display.data1)
-                {
-                    case SDL_ORIENTATION_LANDSCAPE:
-                        show_important_message(1, "landscape");
-                        break;
-                    case SDL_ORIENTATION_LANDSCAPE_FLIPPED:
-                        show_important_message(1, "landscape (flipped)");
-                        break;
-                    case SDL_ORIENTATION_PORTRAIT:
-                        show_important_message(1, "portrait");
-                        break;
-                    case SDL_ORIENTATION_PORTRAIT_FLIPPED:
-                        show_important_message(1, "portrait (flipped)");
-                        break;
-                }
-                break;
-            case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
-                g_width = event.window.data1;
-                g_height = event.window.data2;
-                break;
-            case SDL_EVENT_WINDOW_SHOWN:
-                g_foreground = 1;
-                break;
-            case SDL_EVENT_WINDOW_HIDDEN:
-                g_foreground = 0;
-                break;
-#if !defined(SDL_PLATFORM_ANDROID)
-            case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                    "mouse button down: which=%d, [%g, %g]",
-                    event.button.which, event.button.x, event.button.y);
-                if (event.button.which < ARRAY_SIZE(g_locations))
-                {
-                    g_locations[event.button.which].valid = 1;
-                    g_locations[event.button.which].rect.x =
-                        event.button.x - RECT_W / 2;
-                    g_locations[event.button.which].rect.y =
-                        event.button.y - RECT_W / 2;
-                }
+            continue;
+        }
+
+        if (SDL_strncmp(argv[i], "--pacing=", 9) == 0)
+        {
+            if (!scheduler_parse_pacing(argv[i] + 9, &pacing, &target_fps))
+            {
+                SDL_Log("Unknown pacing '%s', expected vsync, uncapped or "
+                        "a frame rate", argv[i] + 9);
+            }
+        }
+        else if (SDL_strncmp(argv[i], "--sim-hz=", 9) == 0)
+        {
+            sim_hz = SDL_atof(argv[i] + 9);
+        }
+        else if (SDL_strcmp(argv[i], "--profile") == 0)
+        {
+            g_profiler.overlay = true;
+        }
+        else if (SDL_strncmp(argv[i], "--profile-csv=", 14) == 0)
+        {
+            g_profileCsv = argv[i] + 14;
+        }
+        else if (SDL_strcmp(argv[i], "--late-latch") == 0)
+        {
+            late_latch = true;
+        }
+        else if (SDL_strncmp(argv[i], "--renderer=", 11) == 0)
+        {
+            /* raster-scalar skips the SIMD kernels, for comparison.
+               Anything else names an SDL render driver. */
+            const char *name = argv[i] + 11;
+            g_backend = BACKEND_RENDERER;
+            g_renderDriver = NULL;
+            if (SDL_strcmp(name, "raster") == 0 ||
+                SDL_strcmp(name, "raster-scalar") == 0)
+            {
+                g_backend = BACKEND_RASTER;
+                g_rasterSimd = SDL_strcmp(name, "raster-scalar") != 0;
+            }
+            else
+            {
+                g_renderDriver = name;
+            }
+        }
+        else if (SDL_strcmp(argv[i], "--scene") == 0)
+        {
+            g_useScene = true;
+        }
+        else if (SDL_strcmp(argv[i], "--no-layers") == 0)
+        {
+            g_useLayers = false;
+        }
+        else if (SDL_strncmp(argv[i], "--raster-threads=", 17) == 0)
+        {
+            g_rasterThreads = SDL_atoi(argv[i] + 17);
+        }
+        else if (SDL_strcmp(argv[i], "--startup-trace") == 0)
+        {
+            g_startupTrace = "startup-trace.json";
+        }
+        else if (SDL_strncmp(argv[i], "--startup-trace=", 16) == 0)
+        {
+            g_startupTrace = argv[i] + 16;
+        }
 #if defined(WITH_MIXER)
-                if (g_audio != NULL && !MIX_PlayAudio(g_mixer, g_audio))
-                {
-                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                        "Failed to play audio (%s)", SDL_GetError());
-                }
+        else if (SDL_strncmp(argv[i], "--music=", 8) == 0)
+        {
+            g_musicPath = argv[i] + 8;
+        }
+        else if (SDL_strncmp(argv[i], "--audio-budget=", 15) == 0)
+        {
+            /* MB on the command line */
+            g_audioBudget = (Sint64)SDL_atoi(argv[i] + 15) * 1024 * 1024;
+        }
 #endif
-                break;
-            case SDL_EVENT_MOUSE_BUTTON_UP:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                    "mouse button up: which=%d, [%g, %g]",
-                    event.button.which, event.button.x, event.button.y);
-                if (event.button.which < ARRAY_SIZE(g_locations))
-                {
-                    g_locations[event.button.which].valid = 0;
-                }
-                break;
-            case SDL_EVENT_MOUSE_MOTION:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "mouse move: button=%d",
-                    event.motion.which);
-                if (event.button.which < ARRAY_SIZE(g_locations))
-                {
-                    g_locations[event.button.which].rect.x =
-                        event.motion.x - RECT_W / 2;
-                    g_locations[event.button.which].rect.y =
-                        event.motion.y - RECT_W / 2;
-                }
-                break;
-            case SDL_EVENT_WILL_ENTER_BACKGROUND:
-                g_foreground = 0;
-                break;
-            case SDL_EVENT_DID_ENTER_FOREGROUND:
-                g_foreground = 1;
-                break;
+    }
+
+    linked_version = SDL_GetVersion();
+    SDL_Log("We compiled against SDL version %u.%u.%u ...\n", SDL_MAJOR_VERSION,
+        SDL_MINOR_VERSION, SDL_MICRO_VERSION);
+    SDL_Log("But we are linking against SDL version %u.%u.%u.\n",
+        SDL_VERSIONNUM_MAJOR(linked_version),
+        SDL_VERSIONNUM_MINOR(linked_version),
+        SDL_VERSIONNUM_MICRO(linked_version));
+
+    if (g_bench.enabled)
+    {
+        /* Runs on GPU-less machines and as fast as possible */
+        bench_configure(&g_bench);
+        pacing = SCHEDULER_PACING_UNCAPPED;
+    }
+    if (g_renderDriver)
+    {
+        /* After bench_configure, so benchmarks can pick a renderer too */
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, g_renderDriver);
+    }
+
+    SDL_SetHint("SDL_MIXER_DISABLE_DRFLAC", "1");
+    SDL_SetHint("SDL_MIXER_DISABLE_DRMP3", "1");
+
+    // Disable mouse event synthesis from touch events
+    SDL_SetHint(SDL_HINT_TOUCH_MOUSE_EVENTS, "0");
+    SDL_SetHint(SDL_HINT_MOUSE_TOUCH_EVENTS, "0");
+    // Pens are tracked as pointers of their own
+    SDL_SetHint(SDL_HINT_PEN_MOUSE_EVENTS, "0");
+    SDL_SetHint(SDL_HINT_PEN_TOUCH_EVENTS, "0");
+
+    int span = trace_begin("SDL_Init");
+    if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+        SDL_Log("SDL_Init failed (%s)", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    trace_end(span);
+
+    /* Assets are opened by logical name. Android reads them from the APK's
+       assets; desktop builds run from the repository root and the web
+       build embeds them under the same path. */
+    span = trace_begin("vfs");
+#ifdef __ANDROID__
+    vfs_init(&g_vfs, "");
+#else
+    vfs_init(&g_vfs, "app/src/main/assets/");
+#endif // __ANDROID__
+#if defined(WITH_PAK)
+    mount_archive();
+#endif
+    trace_end(span);
+
+    /* Assets decode in the background while the first frames show */
+    span = trace_begin("loader");
+    if (!loader_init(&g_loader, &g_vfs))
+    {
+        SDL_Log("Couldn't create the asset loader (%s)", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    trace_end(span);
+
+#if defined(WITH_IMAGE)
+    {
+        int v = IMG_Version();
+        SDL_Log("SDL3_image version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
+            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+    }
 #endif
-#if defined(SDL_PLATFORM_ANDROID) || defined(SDL_PLATFORM_EMSCRIPTEN)
-            case SDL_EVENT_FINGER_DOWN:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                    "finger down: fingerID=%d, [%f, %f]",
-                    (int)event.tfinger.fingerID, event.tfinger.x,
-                    event.tfinger.y);
-                if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                {
-                    g_locations[event.tfinger.fingerID].valid = 1;
-                    g_locations[event.tfinger.fingerID].rect.x =
-                        g_width * event.tfinger.x - RECT_W / 2;
-                    g_locations[event.tfinger.fingerID].rect.y =
-                        g_height * event.tfinger.y - RECT_W / 2;
-                }
 
 #if defined(WITH_MIXER)
-                // Play the sound effect
-                MIX_PlayAudio(g_mixer, g_audio);
+    {
+        int v = MIX_Version();
+        SDL_Log("SDL3_mixer version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
+            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+    }
+
+    // Enable debug logging
+    SDL_SetLogPriorities(SDL_LOG_PRIORITY_DEBUG);
 #endif
 
-                break;
-            case SDL_EVENT_FINGER_UP:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                    "finger up: fingerID=%d, [%f, %f]",
-                    (int)event.tfinger.fingerID, event.tfinger.x,
-                    event.tfinger.y);
-                if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                {
-                    SDL_Log("fingerID: %d", (int)event.tfinger.fingerID);
-                    g_locations[event.tfinger.fingerID].valid = 0;
-                }
-                break;
-            case SDL_EVENT_FINGER_MOTION:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "finger move: button=%d",
-                    event.motion.which);
-                if (event.tfinger.fingerID >= 0 && event.tfinger.fingerID < (int)ARRAY_SIZE(g_locations))
-                {
-                    g_locations[event.tfinger.fingerID].rect.x =
-                        g_width * event.tfinger.x - RECT_W / 2;
-                    g_locations[event.tfinger.fingerID].rect.y =
-                        g_height * event.tfinger.y - RECT_W / 2;
-                }
-                break;
-            case SDL_EVENT_TERMINATING:
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
-                    "Received SDL_EVENT_TERMINATING");
-                g_quit = 1;
-                break;
+    /* The audio device and SDL_ttf come up alongside the window instead of
+       before it; subsystems_ready() finishes the job */
+    subsystems_start(&g_subsystems);
+
+#if defined(WITH_NET)
+    {
+        int v = NET_Version();
+        SDL_Log("SDL3_net version %d.%d.%d", SDL_VERSIONNUM_MAJOR(v),
+            SDL_VERSIONNUM_MINOR(v), SDL_VERSIONNUM_MICRO(v));
+    }
 #endif
-            case SDL_EVENT_KEY_UP:
-                switch (event.key.key)
-                {
-                    case SDLK_ESCAPE:
-                        g_quit = 1;
-                        break;
-                    case SDLK_RETURN:
-                        if (event.key.mod & SDL_KMOD_ALT)
-                        {
-                            g_fullscreen = !g_fullscreen;
-                            SDL_SetWindowFullscreen(g_window, g_fullscreen);
-                        }
-                        break;
-                }
-                break;
+
+    int width = 640;
+    int height = 480;
+    int flags = SDL_WINDOW_RESIZABLE;
+#if defined(SDL_PLATFORM_ANDROID)
+    flags |= SDL_WINDOW_FULLSCREEN;
+#endif
+
+    char title[32];
+
+    SDL_snprintf(title, sizeof(title), "An SDL %d.%d.%d window",
+        SDL_VERSIONNUM_MAJOR(linked_version),
+        SDL_VERSIONNUM_MINOR(linked_version),
+        SDL_VERSIONNUM_MICRO(linked_version));
+    span = trace_begin("window");
+    g_window = SDL_CreateWindow(title, width, height, flags);
+
+    if (g_window == NULL)
+    {
+        show_important_message(5, "Could not create window %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    trace_end(span);
+    SDL_Log("Window created!");
+
+    span = trace_begin("renderer");
+    if (g_backend == BACKEND_RASTER)
+    {
+        if (!raster_init(&g_raster, g_window, g_rasterSimd,
+                g_rasterThreads))
+        {
+            show_important_message(5, "Could not start the rasterizer: %s",
+                SDL_GetError());
+            return SDL_APP_FAILURE;
         }
+        trace_end(span);
+        SDL_Log("Rasterizer started, %s kernels on %d threads",
+            g_raster.kernels.name, g_raster.thread_count + 1);
     }
+    else if (g_backend == BACKEND_RENDERER)
+    {
+        g_renderer = SDL_CreateRenderer(g_window, NULL);
+        if (g_renderer == NULL)
+        {
+            show_important_message(5, "Could not create renderer: %s",
+                SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        trace_end(span);
+        SDL_Log("Renderer created!");
 
-    if (g_foreground)
+        if (!batch_init(&g_batch, g_renderer, BATCH_QUADS))
+        {
+            SDL_Log("Couldn't allocate the quad batch");
+            return SDL_APP_FAILURE;
+        }
+        if (g_useScene)
+        {
+            scene_init(&g_scene, g_renderer, &g_batch);
+            if (!build_scene())
+            {
+                SDL_Log("Couldn't build the scene");
+                return SDL_APP_FAILURE;
+            }
+            SDL_Log("Drawing a retained scene with partial redraws");
+        }
+        else if (g_useLayers)
+        {
+            layer_init(&g_staticLayer, g_renderer, &g_batch);
+        }
+    }
+    else if (g_useScene)
     {
-        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
-        SDL_RenderClear(g_renderer);
+        SDL_Log("--scene needs an SDL renderer, drawing every frame");
+        g_useScene = false;
+    }
+
+    scheduler_init(&g_scheduler, pacing, target_fps, sim_hz);
+    scheduler_attach(&g_scheduler, g_renderer, g_window);
+    g_scheduler.lockstep = g_bench.enabled;
 
 #if defined(WITH_IMAGE)
+    atlas_init(&g_atlas, g_renderer, ATLAS_DEFAULT_PAGE_SIZE);
+    loader_load_image(&g_loader, ASSET_CRATE, "sprites/crate.png");
+#endif
 
-#ifdef __ANDROID__
-        if (g_imageTex)
+    pointers_init(&g_pointers);
+    motion_init(&g_motion);
+    if (late_latch && !latch_start(&g_latch))
+    {
+        SDL_Log("Couldn't watch events for late latching (%s)",
+            SDL_GetError());
+    }
+
+    show_important_message(1, "Entering the loop");
+
+    g_width = width;
+    g_height = height;
+    g_fullscreen = 0;
+    g_foreground = 1;
+    g_quit = 0;
+
+    if (g_bench.enabled)
+    {
+        /* Measure the steady state, not assets arriving mid-run */
+        subsystems_wait(&g_subsystems);
+        if (subsystems_poll(&g_subsystems))
         {
-            SDL_FRect dst = { 50, 50, 512, 512 };
-            SDL_RenderTexture(g_renderer, g_imageTex, NULL, &dst);
+            subsystems_ready();
         }
-#endif // __ANDROID__
+        loader_wait(&g_loader);
+        receive_assets(SDL_MAX_SINT64);
+        if (!bench_begin(&g_bench))
+        {
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+/* Called by SDL as events arrive, so input is handled at event rate rather
+   than once per frame. */
+SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
+{
+    (void)appstate;
+
+    profiler_begin(&g_profiler, PROFILER_PHASE_EVENTS);
+    if (!coalesce_motion(event))
+    {
+        flush_motion(false);
+        handle_event(event);
+    }
+    profiler_end(&g_profiler, PROFILER_PHASE_EVENTS);
+    return g_quit ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+}
 
-#ifdef __WIN32__
-        if (g_imageTex)
+/* Called by SDL on the platform's frame clock (requestAnimationFrame on the
+   web, SDL_HINT_MAIN_CALLBACK_RATE elsewhere). It never sleeps: run as many
+   fixed steps as real time demands and render the interpolated state, but
+   only when something changed. Once the scene is static the scheduler parks
+   iteration until the next event. */
+SDL_AppResult SDL_AppIterate(void *appstate)
+{
+    bool rendered = false;
+
+    (void)appstate;
+
+    profiler_begin(&g_profiler, PROFILER_PHASE_EVENTS);
+    flush_motion(false);
+    profiler_end(&g_profiler, PROFILER_PHASE_EVENTS);
+
+    if (subsystems_poll(&g_subsystems))
+    {
+        subsystems_ready();
+    }
+    if (assets_pending())
+    {
+        receive_assets(LOADER_UPLOAD_BUDGET);
+    }
+
+    profiler_begin(&g_profiler, PROFILER_PHASE_UPDATE);
+    const int steps = scheduler_begin_frame(&g_scheduler);
+    for (int i = 0; i < steps; i++)
+    {
+        g_animating = update();
+    }
+    profiler_end(&g_profiler, PROFILER_PHASE_UPDATE);
+
+    if (!g_foreground)
+    {
+        /* Nothing can be shown; coming back to the foreground invalidates */
+        motion_clear_history(&g_motion);
+        scheduler_end_frame(&g_scheduler, true, false);
+        profiler_frame_end(&g_profiler);
+        return g_quit ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+    }
+
+    if (g_bench.enabled)
+    {
+        /* Every frame is measured, changed or not */
+        scheduler_invalidate(&g_scheduler);
+    }
+
+    if (g_latch.enabled)
+    {
+        /* Sample the freshest pointer positions as late as possible */
+        profiler_begin(&g_profiler, PROFILER_PHASE_EVENTS);
+        if (latch_drain(&g_latch, &g_motion, g_width, g_height) > 0)
         {
-            SDL_FRect dst = { 50, 50, 128, 128 };
-            SDL_RenderTexture(g_renderer, g_imageTex, NULL, &dst);
+            flush_motion(true);
+            LOG_DEBUG(SDL_LOG_CATEGORY_INPUT, "latched input %.3f ms old",
+                g_latch.age_ns / 1e6);
         }
-#endif // __WIN32__
+        profiler_end(&g_profiler, PROFILER_PHASE_EVENTS);
+    }
 
-#ifdef __EMSCRIPTEN__
-        if (g_imageTex)
+    if (scheduler_needs_render(&g_scheduler))
+    {
+        const int span = g_started ? -1 : trace_begin("frame");
+        profiler_begin(&g_profiler, PROFILER_PHASE_RENDER);
+        render(scheduler_alpha(&g_scheduler));
+        profiler_end(&g_profiler, PROFILER_PHASE_RENDER);
+
+        /* Not timed, so the overlay doesn't show up in its own graph. It
+           needs a renderer to draw with. */
+        if (g_renderer)
         {
-            SDL_FRect dst = { 50, 50, 128, 128 };
-            SDL_RenderTexture(g_renderer, g_imageTex, NULL, &dst);
+            profiler_draw_overlay(&g_profiler, g_renderer);
         }
-#endif // __EMSCRIPTEN__
 
-#endif
+        /* The rasterizer only recorded the frame; its pixels are drawn here */
+        profiler_begin(&g_profiler, PROFILER_PHASE_PRESENT);
+        switch (g_backend)
+        {
+            case BACKEND_RASTER:
+                raster_present(&g_raster);
+                break;
+            default:
+                SDL_RenderPresent(g_renderer);
+                break;
+        }
+        profiler_end(&g_profiler, PROFILER_PHASE_PRESENT);
+        trace_end(span);
+        rendered = true;
 
-#if defined(WITH_TTF)
-        if (g_textTexture)
+        if (!g_started && g_subsystems.collected &&
+            loader_outstanding(&g_loader) == 0)
         {
-            float tw, th;
-            SDL_GetTextureSize(g_textTexture, &tw, &th);
-            SDL_FRect dst = { 200.0f, 50.0f, tw, th };
-            SDL_RenderTexture(g_renderer, g_textTexture, NULL, &dst);
+            finish_startup();
         }
-#endif
+    }
+    /* The overlay graph scrolls, so keep drawing while it is visible */
+    motion_clear_history(&g_motion);
+    scheduler_end_frame(&g_scheduler, rendered,
+        g_animating || g_profiler.overlay);
+    profiler_frame_end(&g_profiler);
 
-        for (size_t i = 0; i < ARRAY_SIZE(g_locations); i++)
+    if (g_bench.enabled)
+    {
+        if (bench_record(&g_bench, &g_profiler))
         {
-            if (g_locations[i].valid)
+            char name[64];
+            switch (g_backend)
             {
-                SDL_SetRenderDrawColor(g_renderer, COLORS[i].r, COLORS[i].g,
-                    COLORS[i].b, COLORS[i].a);
-                SDL_RenderFillRect(g_renderer, &g_locations[i].rect);
+                case BACKEND_RASTER:
+                    SDL_snprintf(name, sizeof(name), "raster (%s, %d threads)",
+                        g_raster.kernels.name, g_raster.thread_count + 1);
+                    break;
+                default:
+                    SDL_strlcpy(name, SDL_GetRendererName(g_renderer),
+                        sizeof(name));
+                    break;
             }
+            bench_report(&g_bench, &g_profiler, name);
+            if (g_useScene && g_sceneShown > 0)
+            {
+                SDL_Log("bench: scene redrew %.1f%% of the pixels shown",
+                    100.0 * (double)g_sceneRedrawn / (double)g_sceneShown);
+            }
+            return SDL_APP_SUCCESS;
         }
-        SDL_RenderPresent(g_renderer);
+        /* Delivered through SDL_AppEvent before the next iteration */
+        bench_push_input(&g_bench, g_window, g_width, g_height);
     }
 
-    /* Small delay to avoid busy-looping inside the browser */
-    SDL_Delay(10);
+    return g_quit ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+}
+
+/* SDL calls SDL_Quit() itself once this returns. */
+void SDL_AppQuit(void *appstate, SDL_AppResult result)
+{
+    (void)appstate;
+    (void)result;
 
-    /* If quit requested, cancel the Emscripten main loop and cleanup */
-    if (g_quit)
+    if (g_profileCsv)
     {
-        emscripten_cancel_main_loop();
-        /* Cleanup (similar to native path) */
-        SDL_DestroyRenderer(g_renderer);
-        SDL_DestroyWindow(g_window);
+        if (profiler_write_csv(&g_profiler, g_profileCsv))
+        {
+            SDL_Log("Frame profile written to %s", g_profileCsv);
+        }
+        else
+        {
+            SDL_Log("Couldn't write %s (%s)", g_profileCsv, SDL_GetError());
+        }
+    }
+    /* The mixer and SDL_ttf may still be starting */
+    subsystems_wait(&g_subsystems);
+    loader_quit(&g_loader);
+    latch_stop(&g_latch);
+    profiler_quit(&g_profiler);
+    bench_quit(&g_bench);
+    layer_quit(&g_staticLayer);
+    scene_quit(&g_scene);
+    SDL_free(g_benchNodes);
+    batch_quit(&g_batch);
+    raster_quit(&g_raster);
 
 #if defined(WITH_IMAGE)
-        if (g_imageTex)
-            SDL_DestroyTexture(g_imageTex);
+    atlas_quit(&g_atlas);
 #endif
 
 #if defined(WITH_TTF)
-        if (g_textTexture)
-            SDL_DestroyTexture(g_textTexture);
-        if (g_font)
-            TTF_CloseFont(g_font);
+    if (g_text)
+        TTF_DestroyText(g_text);
+    SDL_DestroySurface(g_textSurface);
+    if (g_textEngine)
+        TTF_DestroyRendererTextEngine(g_textEngine);
+    if (g_font)
+        TTF_CloseFont(g_font);
+    if (g_subsystems.ttf)
         TTF_Quit();
 #endif
 
+    SDL_DestroyRenderer(g_renderer);
+    SDL_DestroyWindow(g_window);
+
 #if defined(WITH_MIXER)
-        if (g_audio)
-            MIX_DestroyAudio(g_audio);
-        if (g_mixer)
-            MIX_DestroyMixer(g_mixer);
+    voices_quit(&g_voices);
+    sound_free(&g_music);
+    sound_free(&g_clickSound);
+    audio_cache_quit(&g_audioCache);
+    if (g_subsystems.mixer)
+        MIX_DestroyMixer(g_subsystems.mixer);
+    if (g_subsystems.mixer_init)
         MIX_Quit();
 #endif
-        SDL_Quit();
-    }
+
+    /* Streams opened from the archive point into its mapping */
+    vfs_unmount(&g_vfs);
+
+    logger_quit();
 }
-#endif /* __EMSCRIPTEN__ */
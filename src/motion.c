@@ -0,0 +1,60 @@
+#include "motion.h"
+
+static bool key_equal(const struct PointerKey *a, const struct PointerKey *b)
+{
+    return a->kind == b->kind && a->device == b->device && a->id == b->id;
+}
+
+void motion_init(struct MotionQueue *q)
+{
+    q->pending_count = 0;
+    q->history_count = 0;
+    q->history_dropped = 0;
+}
+
+bool motion_push(struct MotionQueue *q, const struct MotionSample *sample)
+{
+    struct MotionPending *pending = NULL;
+
+    /* Only a handful of pointers move per frame, a scan beats hashing */
+    for (int i = 0; i < q->pending_count; i++)
+    {
+        if (key_equal(&q->pending[i].last.key, &sample->key))
+        {
+            pending = &q->pending[i];
+            break;
+        }
+    }
+    if (!pending)
+    {
+        if (q->pending_count == MOTION_MAX_PENDING)
+        {
+            return false;
+        }
+        pending = &q->pending[q->pending_count++];
+        pending->samples = 0;
+    }
+    pending->last = *sample;
+    pending->samples++;
+
+    if (q->history_count < MOTION_MAX_HISTORY)
+    {
+        q->history[q->history_count++] = *sample;
+    }
+    else
+    {
+        q->history_dropped++;
+    }
+    return true;
+}
+
+void motion_clear_pending(struct MotionQueue *q)
+{
+    q->pending_count = 0;
+}
+
+void motion_clear_history(struct MotionQueue *q)
+{
+    q->history_count = 0;
+    q->history_dropped = 0;
+}
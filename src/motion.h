@@ -0,0 +1,55 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <SDL3/SDL.h>
+
+#include "pointers.h"
+
+/* ----------------------------
+   Motion event coalescing
+   ---------------------------- */
+
+#define MOTION_MAX_PENDING 64    /* distinct pointers moving in one frame */
+#define MOTION_MAX_HISTORY 4096  /* raw samples kept per frame */
+
+struct MotionSample
+{
+    struct PointerKey key;
+    float x, y;          /* window coordinates */
+    Uint64 timestamp;    /* event timestamp, ns */
+};
+
+/* Latest position of a pointer this frame, standing in for `samples`
+   motion events */
+struct MotionPending
+{
+    struct MotionSample last;
+    int samples;
+};
+
+/* Motion events are folded into one pending move per pointer and handed
+   to the handlers once per frame, so their cost no longer scales with
+   the device polling rate. Every raw sample is also appended to history,
+   in arrival order, for consumers that need the whole path (strokes). */
+struct MotionQueue
+{
+    struct MotionPending pending[MOTION_MAX_PENDING];
+    int pending_count;
+    struct MotionSample history[MOTION_MAX_HISTORY];
+    int history_count;
+    int history_dropped;
+};
+
+void motion_init(struct MotionQueue *q);
+
+/* Folds a sample into its pointer's pending move. Returns false when a
+   new pointer doesn't fit; flush and push again. */
+bool motion_push(struct MotionQueue *q, const struct MotionSample *sample);
+
+/* Forgets the pending moves once the caller has dispatched them */
+void motion_clear_pending(struct MotionQueue *q);
+
+/* Starts a new frame of history */
+void motion_clear_history(struct MotionQueue *q);
+
+#endif /* MOTION_H */
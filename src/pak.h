@@ -0,0 +1,51 @@
+#ifndef PAK_H
+#define PAK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ----------------------------
+   Packed asset archive format, shared by the game and tools/pack.c
+
+   header | entries[count] | names | data
+
+   Entries are sorted by (hash, name) for binary search. Names are not
+   NUL-terminated. Each file's data starts at a multiple of PAK_ALIGN from
+   the start of the archive. Integers are little-endian.
+   ---------------------------- */
+
+#define PAK_MAGIC "SPAK"
+#define PAK_VERSION 1
+#define PAK_ALIGN 16
+
+struct PakHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t names_size;
+};
+
+struct PakEntry
+{
+    uint32_t hash;        /* pak_hash(name) */
+    uint32_t name_offset; /* from the start of the names block */
+    uint32_t name_length;
+    uint32_t reserved;
+    uint64_t offset;      /* from the start of the archive */
+    uint64_t size;
+};
+
+/* FNV-1a */
+static inline uint32_t pak_hash(const char *name, size_t length)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#endif /* PAK_H */
@@ -0,0 +1,111 @@
+#include "pointers.h"
+
+#define POINTERS_MASK (POINTERS_TABLE_SIZE - 1)
+
+SDL_COMPILE_TIME_ASSERT(pointers_load, POINTERS_TABLE_SIZE >= 2 * POINTERS_MAX);
+SDL_COMPILE_TIME_ASSERT(pointers_index, POINTERS_MAX <= SDL_MAX_SINT16);
+
+static Uint32 hash_key(const struct PointerKey *key)
+{
+    /* splitmix64 finalizer; mouse and finger IDs are often small and
+       sequential, so they need spreading before masking */
+    Uint64 x = key->device * 0x9E3779B97F4A7C15ull;
+    x ^= key->id + 0xC2B2AE3D27D4EB4Full + ((Uint64)key->kind << 56);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return (Uint32)x;
+}
+
+static bool key_equal(const struct PointerKey *a, const struct PointerKey *b)
+{
+    return a->kind == b->kind && a->device == b->device && a->id == b->id;
+}
+
+/* Slot holding key, or the empty slot where it would be inserted. */
+static int find_slot(const struct PointerTable *t, const struct PointerKey *key)
+{
+    int i = (int)(hash_key(key) & POINTERS_MASK);
+    while (t->slots[i] >= 0 && !key_equal(&t->dense[t->slots[i]].key, key))
+    {
+        i = (i + 1) & POINTERS_MASK;
+    }
+    return i;
+}
+
+void pointers_init(struct PointerTable *t)
+{
+    t->count = 0;
+    t->next_color = 0;
+    for (int i = 0; i < POINTERS_TABLE_SIZE; i++)
+    {
+        t->slots[i] = -1;
+    }
+}
+
+struct Pointer *pointers_find(struct PointerTable *t,
+    const struct PointerKey *key)
+{
+    const int slot = find_slot(t, key);
+    return t->slots[slot] >= 0 ? &t->dense[t->slots[slot]] : NULL;
+}
+
+struct Pointer *pointers_insert(struct PointerTable *t,
+    const struct PointerKey *key, int palette_size)
+{
+    const int slot = find_slot(t, key);
+    if (t->slots[slot] >= 0)
+    {
+        return &t->dense[t->slots[slot]];
+    }
+    if (t->count == POINTERS_MAX)
+    {
+        return NULL;
+    }
+
+    struct Pointer *p = &t->dense[t->count];
+    SDL_zerop(p);
+    p->key = *key;
+    p->color = t->next_color++ % palette_size;
+    t->slots[slot] = (Sint16)t->count++;
+    return p;
+}
+
+bool pointers_remove(struct PointerTable *t, const struct PointerKey *key)
+{
+    int hole = find_slot(t, key);
+    const int index = t->slots[hole];
+    if (index < 0)
+    {
+        return false;
+    }
+
+    /* Backward-shift deletion: pull later entries of the probe run into the
+       hole unless that would move them before their home slot. Keeps
+       lookups tombstone-free. */
+    for (int j = (hole + 1) & POINTERS_MASK; t->slots[j] >= 0;
+         j = (j + 1) & POINTERS_MASK)
+    {
+        const int home = (int)(hash_key(&t->dense[t->slots[j]].key) & POINTERS_MASK);
+        const bool stays = (hole <= j) ? (hole < home && home <= j)
+                                       : (hole < home || home <= j);
+        if (!stays)
+        {
+            t->slots[hole] = t->slots[j];
+            hole = j;
+        }
+    }
+    t->slots[hole] = -1;
+
+    /* Keep the dense array packed by moving the last pointer into the gap */
+    const int last = t->count - 1;
+    if (index != last)
+    {
+        t->slots[find_slot(t, &t->dense[last].key)] = (Sint16)index;
+        t->dense[index] = t->dense[last];
+    }
+    t->count--;
+    return true;
+}
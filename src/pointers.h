@@ -0,0 +1,62 @@
+#ifndef POINTERS_H
+#define POINTERS_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Pointer tracker (mice, fingers, pens)
+   ---------------------------- */
+
+#define POINTERS_MAX 1024        /* concurrent pointers */
+#define POINTERS_TABLE_SIZE 2048 /* hash slots, power of two, >= 2 * max */
+
+enum PointerKind
+{
+    POINTER_MOUSE,
+    POINTER_FINGER,
+    POINTER_PEN,
+};
+
+/* Identity of a pointer. Finger IDs are only unique per touch device, so
+   the device is part of the key. */
+struct PointerKey
+{
+    enum PointerKind kind;
+    Uint64 device; /* SDL_MouseID, SDL_TouchID or SDL_PenID */
+    Uint64 id;     /* SDL_FingerID, 0 for mice and pens */
+};
+
+struct Pointer
+{
+    struct PointerKey key;
+    int color;        /* index into the app's palette */
+    SDL_FRect rect;   /* simulated position */
+    SDL_FRect prev;   /* position at the previous simulation step */
+    SDL_FRect target; /* latest position reported by input */
+};
+
+/* Sparse set: an open-addressing hash table maps keys to indices into a
+   dense array. Insert, find and remove are O(1) on average, and update and
+   draw loops walk dense[0..count) linearly. Removal moves the last pointer
+   into the hole, so the dense order is not stable. */
+struct PointerTable
+{
+    struct Pointer dense[POINTERS_MAX];
+    int count;
+    Sint16 slots[POINTERS_TABLE_SIZE]; /* dense index, -1 when empty */
+    int next_color;
+};
+
+void pointers_init(struct PointerTable *t);
+
+struct Pointer *pointers_find(struct PointerTable *t,
+    const struct PointerKey *key);
+
+/* Returns the existing pointer for key, or a new one. NULL when full. */
+struct Pointer *pointers_insert(struct PointerTable *t,
+    const struct PointerKey *key, int palette_size);
+
+/* Returns true if the key was present. */
+bool pointers_remove(struct PointerTable *t, const struct PointerKey *key);
+
+#endif /* POINTERS_H */
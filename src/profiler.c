@@ -0,0 +1,340 @@
+#include "profiler.h"
+
+#define PROFILER_MASK (PROFILER_CAPACITY - 1)
+
+/* Overlay layout */
+#define OVERLAY_FRAMES 240          /* bars in the graph */
+#define OVERLAY_BAR_W 2.0f
+#define OVERLAY_GRAPH_H 120.0f
+#define OVERLAY_GRAPH_MS 33.3       /* frame time at the top of the graph */
+#define OVERLAY_LABEL_H 24.0f
+#define OVERLAY_LABEL_PT 18.0f
+#define OVERLAY_MARGIN 10.0f
+#define OVERLAY_REFRESH_MS 250      /* how often the summary is recomputed */
+
+static const SDL_Color PHASE_COLORS[PROFILER_PHASE_COUNT] = {
+    { 80, 140, 255, 255 }, /* events */
+    { 80, 220, 80, 255 },  /* update */
+    { 240, 200, 40, 255 }, /* render */
+    { 150, 150, 150, 255 } /* present */
+};
+
+static const char *const PHASE_NAMES[PROFILER_PHASE_COUNT] = {
+    "events",
+    "update",
+    "render",
+    "present",
+};
+
+void profiler_init(struct Profiler *p)
+{
+    SDL_zerop(p);
+    p->frequency = SDL_GetPerformanceFrequency();
+    p->frame_start = SDL_GetPerformanceCounter();
+}
+
+void profiler_quit(struct Profiler *p)
+{
+#if defined(WITH_TTF)
+    if (p->label)
+    {
+        TTF_DestroyText(p->label);
+        p->label = NULL;
+    }
+    if (p->font)
+    {
+        TTF_CloseFont(p->font);
+        p->font = NULL;
+    }
+#else
+    (void)p;
+#endif
+}
+
+#if defined(WITH_TTF)
+void profiler_set_font(struct Profiler *p, TTF_TextEngine *engine,
+    TTF_Font *font)
+{
+    p->font = TTF_CopyFont(font);
+    if (!p->font || !TTF_SetFontSize(p->font, OVERLAY_LABEL_PT))
+    {
+        return;
+    }
+    p->label = TTF_CreateText(engine, p->font, "", 0);
+}
+#endif
+
+void profiler_begin(struct Profiler *p, enum ProfilerPhase phase)
+{
+    p->phase_start[phase] = SDL_GetPerformanceCounter();
+}
+
+void profiler_end(struct Profiler *p, enum ProfilerPhase phase)
+{
+    p->pending[phase] += SDL_GetPerformanceCounter() - p->phase_start[phase];
+}
+
+void profiler_frame_end(struct Profiler *p)
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const Uint32 head = SDL_GetAtomicU32(&p->head);
+    struct ProfilerFrame *frame = &p->frames[head & PROFILER_MASK];
+
+    frame->index = head;
+    frame->interval = now - p->frame_start;
+    frame->work = 0;
+    for (int i = 0; i < PROFILER_PHASE_COUNT; i++)
+    {
+        frame->phase[i] = p->pending[i];
+        frame->work += p->pending[i];
+        p->pending[i] = 0;
+    }
+    p->frame_start = now;
+
+    /* Publish only after the slot is complete */
+    SDL_SetAtomicU32(&p->head, head + 1);
+}
+
+double profiler_ticks_to_ms(const struct Profiler *p, Uint64 ticks)
+{
+    return (double)ticks * 1000.0 / (double)p->frequency;
+}
+
+int profiler_snapshot(struct Profiler *p, struct ProfilerFrame *out,
+    int max_frames)
+{
+    const Uint32 head = SDL_GetAtomicU32(&p->head);
+    Uint32 count = head < PROFILER_CAPACITY ? head : PROFILER_CAPACITY;
+
+    if (count > (Uint32)max_frames)
+    {
+        count = (Uint32)max_frames;
+    }
+    for (Uint32 i = 0; i < count; i++)
+    {
+        out[i] = p->frames[(head - count + i) & PROFILER_MASK];
+    }
+    return (int)count;
+}
+
+static int SDLCALL compare_ticks(const void *a, const void *b)
+{
+    const Uint64 x = *(const Uint64 *)a;
+    const Uint64 y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+void profiler_sort_ticks(Uint64 *ticks, int count)
+{
+    SDL_qsort(ticks, (size_t)count, sizeof(*ticks), compare_ticks);
+}
+
+double profiler_percentile_ms(const struct Profiler *p, const Uint64 *sorted,
+    int count, int percent)
+{
+    int i = (count * percent + 99) / 100 - 1;
+    if (i < 0)
+    {
+        i = 0;
+    }
+    return profiler_ticks_to_ms(p, sorted[i]);
+}
+
+void profiler_compute_stats(struct Profiler *p, struct ProfilerStats *stats)
+{
+    static struct ProfilerFrame frames[PROFILER_CAPACITY];
+    static Uint64 work[PROFILER_CAPACITY];
+    Uint64 phase_sum[PROFILER_PHASE_COUNT] = { 0 };
+    Uint64 worst = 0;
+
+    SDL_zerop(stats);
+    stats->count = profiler_snapshot(p, frames, PROFILER_CAPACITY);
+    if (stats->count == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < stats->count; i++)
+    {
+        work[i] = frames[i].work;
+        if (frames[i].work >= worst)
+        {
+            worst = frames[i].work;
+            stats->worst_index = frames[i].index;
+        }
+        for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+        {
+            phase_sum[j] += frames[i].phase[j];
+        }
+    }
+    profiler_sort_ticks(work, stats->count);
+
+    stats->p50_ms = profiler_percentile_ms(p, work, stats->count, 50);
+    stats->p95_ms = profiler_percentile_ms(p, work, stats->count, 95);
+    stats->p99_ms = profiler_percentile_ms(p, work, stats->count, 99);
+    stats->worst_ms = profiler_ticks_to_ms(p, worst);
+    for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+    {
+        stats->phase_avg_ms[j] =
+            profiler_ticks_to_ms(p, phase_sum[j]) / stats->count;
+    }
+}
+
+#if defined(WITH_TTF)
+static void refresh_label(struct Profiler *p)
+{
+    const struct ProfilerStats *s = &p->overlay_stats;
+    char text[128];
+
+    if (!p->label)
+    {
+        return;
+    }
+
+    SDL_snprintf(text, sizeof(text),
+        "p50 %.2f  p95 %.2f  p99 %.2f  worst %.2f ms", s->p50_ms, s->p95_ms,
+        s->p99_ms, s->worst_ms);
+    TTF_SetTextString(p->label, text, 0);
+}
+#endif
+
+static float ms_to_y(float bottom, double ms)
+{
+    if (ms > OVERLAY_GRAPH_MS)
+    {
+        ms = OVERLAY_GRAPH_MS;
+    }
+    return bottom - (float)(ms / OVERLAY_GRAPH_MS) * OVERLAY_GRAPH_H;
+}
+
+static void draw_hline(SDL_Renderer *renderer, float x, float w, float y,
+    Uint8 r, Uint8 g, Uint8 b)
+{
+    SDL_FRect line = { x, y, w, 1.0f };
+    SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+    SDL_RenderFillRect(renderer, &line);
+}
+
+void profiler_draw_overlay(struct Profiler *p, SDL_Renderer *renderer)
+{
+    static struct ProfilerFrame frames[OVERLAY_FRAMES];
+    static SDL_FRect bars[PROFILER_PHASE_COUNT][OVERLAY_FRAMES];
+    SDL_BlendMode blend;
+    int output_h = 0;
+
+    if (!p->overlay)
+    {
+        return;
+    }
+
+    const Uint64 now = SDL_GetTicks();
+    if (now >= p->overlay_refresh)
+    {
+        p->overlay_refresh = now + OVERLAY_REFRESH_MS;
+        profiler_compute_stats(p, &p->overlay_stats);
+#if defined(WITH_TTF)
+        refresh_label(p);
+#endif
+    }
+
+    SDL_GetCurrentRenderOutputSize(renderer, NULL, &output_h);
+    const int count = profiler_snapshot(p, frames, OVERLAY_FRAMES);
+    const float x0 = OVERLAY_MARGIN;
+    const float bottom = (float)output_h - OVERLAY_MARGIN;
+    const float width = OVERLAY_FRAMES * OVERLAY_BAR_W;
+
+    SDL_GetRenderDrawBlendMode(renderer, &blend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    {
+        SDL_FRect panel = { x0 - 4.0f,
+            bottom - OVERLAY_GRAPH_H - OVERLAY_LABEL_H - 8.0f, width + 8.0f,
+            OVERLAY_GRAPH_H + OVERLAY_LABEL_H + 12.0f };
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+        SDL_RenderFillRect(renderer, &panel);
+    }
+    SDL_SetRenderDrawBlendMode(renderer, blend);
+
+    /* Stacked bars, one fill call per phase */
+    int worst_bar = -1;
+    for (int i = 0; i < count; i++)
+    {
+        double base_ms = 0.0;
+        for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+        {
+            const double ms = profiler_ticks_to_ms(p, frames[i].phase[j]);
+            const float top = ms_to_y(bottom, base_ms + ms);
+            const float low = ms_to_y(bottom, base_ms);
+            bars[j][i].x = x0 + i * OVERLAY_BAR_W;
+            bars[j][i].y = top;
+            bars[j][i].w = OVERLAY_BAR_W;
+            bars[j][i].h = low - top;
+            base_ms += ms;
+        }
+        if (p->overlay_stats.count > 0 &&
+            frames[i].index == p->overlay_stats.worst_index)
+        {
+            worst_bar = i;
+        }
+    }
+    for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+    {
+        SDL_SetRenderDrawColor(renderer, PHASE_COLORS[j].r, PHASE_COLORS[j].g,
+            PHASE_COLORS[j].b, PHASE_COLORS[j].a);
+        SDL_RenderFillRects(renderer, bars[j], count);
+    }
+
+    /* Percentile lines across the graph, worst frame as a red column */
+    draw_hline(renderer, x0, width, ms_to_y(bottom, p->overlay_stats.p50_ms),
+        255, 255, 255);
+    draw_hline(renderer, x0, width, ms_to_y(bottom, p->overlay_stats.p95_ms),
+        255, 160, 0);
+    draw_hline(renderer, x0, width, ms_to_y(bottom, p->overlay_stats.p99_ms),
+        255, 60, 0);
+    if (worst_bar >= 0)
+    {
+        SDL_FRect marker = { x0 + worst_bar * OVERLAY_BAR_W,
+            bottom - OVERLAY_GRAPH_H, OVERLAY_BAR_W, OVERLAY_GRAPH_H };
+        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        SDL_RenderFillRect(renderer, &marker);
+    }
+
+#if defined(WITH_TTF)
+    if (p->label)
+    {
+        TTF_DrawRendererText(p->label, x0,
+            bottom - OVERLAY_GRAPH_H - OVERLAY_LABEL_H - 4.0f);
+    }
+#endif
+}
+
+bool profiler_write_csv(struct Profiler *p, const char *path)
+{
+    static struct ProfilerFrame frames[PROFILER_CAPACITY];
+    const int count = profiler_snapshot(p, frames, PROFILER_CAPACITY);
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "w");
+    if (!io)
+    {
+        return false;
+    }
+
+    SDL_IOprintf(io, "frame,interval_ms");
+    for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+    {
+        SDL_IOprintf(io, ",%s_ms", PHASE_NAMES[j]);
+    }
+    SDL_IOprintf(io, ",work_ms\n");
+
+    for (int i = 0; i < count; i++)
+    {
+        SDL_IOprintf(io, "%" SDL_PRIu64 ",%.4f", frames[i].index,
+            profiler_ticks_to_ms(p, frames[i].interval));
+        for (int j = 0; j < PROFILER_PHASE_COUNT; j++)
+        {
+            SDL_IOprintf(io, ",%.4f", profiler_ticks_to_ms(p, frames[i].phase[j]));
+        }
+        SDL_IOprintf(io, ",%.4f\n", profiler_ticks_to_ms(p, frames[i].work));
+    }
+
+    return SDL_CloseIO(io);
+}
@@ -0,0 +1,106 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_TTF)
+#include <SDL3_ttf/SDL_ttf.h>
+#endif
+
+/* ----------------------------
+   Frame profiler
+   ---------------------------- */
+
+/* Number of frames kept in the ring buffer, must be a power of two */
+#define PROFILER_CAPACITY 1024
+
+enum ProfilerPhase
+{
+    PROFILER_PHASE_EVENTS,  /* SDL_AppEvent calls since the previous frame */
+    PROFILER_PHASE_UPDATE,  /* fixed simulation steps */
+    PROFILER_PHASE_RENDER,  /* building the frame on the renderer */
+    PROFILER_PHASE_PRESENT, /* SDL_RenderPresent, including vsync waits */
+    PROFILER_PHASE_COUNT
+};
+
+/* One finished frame. Durations are in SDL_GetPerformanceCounter ticks. */
+struct ProfilerFrame
+{
+    Uint64 index;
+    Uint64 interval; /* since the start of the previous frame */
+    Uint64 phase[PROFILER_PHASE_COUNT];
+    Uint64 work;     /* sum of the phases */
+};
+
+struct ProfilerStats
+{
+    int count;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double worst_ms;
+    Uint64 worst_index;
+    double phase_avg_ms[PROFILER_PHASE_COUNT];
+};
+
+struct Profiler
+{
+    /* Single producer (the main thread) publishes a frame by writing its
+       slot and then bumping head; readers never take a lock. */
+    struct ProfilerFrame frames[PROFILER_CAPACITY];
+    SDL_AtomicU32 head;
+
+    Uint64 frequency;
+    Uint64 frame_start;
+    Uint64 phase_start[PROFILER_PHASE_COUNT];
+    Uint64 pending[PROFILER_PHASE_COUNT]; /* the frame being recorded */
+
+    bool overlay;
+    Uint64 overlay_refresh;
+    struct ProfilerStats overlay_stats;
+#if defined(WITH_TTF)
+    TTF_Font *font;  /* small copy of the app font */
+    TTF_Text *label;
+#endif
+};
+
+void profiler_init(struct Profiler *p);
+void profiler_quit(struct Profiler *p);
+
+#if defined(WITH_TTF)
+/* Draws the overlay summary with engine, using a small copy of font. The
+   label is only reshaped when the numbers change. */
+void profiler_set_font(struct Profiler *p, TTF_TextEngine *engine,
+    TTF_Font *font);
+#endif
+
+void profiler_begin(struct Profiler *p, enum ProfilerPhase phase);
+void profiler_end(struct Profiler *p, enum ProfilerPhase phase);
+
+/* Publishes the frame recorded since the previous call. */
+void profiler_frame_end(struct Profiler *p);
+
+double profiler_ticks_to_ms(const struct Profiler *p, Uint64 ticks);
+
+/* Ascending, for profiler_percentile_ms() */
+void profiler_sort_ticks(Uint64 *ticks, int count);
+
+/* Nearest-rank percentile of count sorted ticks, in ms. The overlay, the
+   CSV and the bench summary all use this, so they agree. */
+double profiler_percentile_ms(const struct Profiler *p, const Uint64 *sorted,
+    int count, int percent);
+
+/* Copies up to max_frames of the most recent frames, oldest first. */
+int profiler_snapshot(struct Profiler *p, struct ProfilerFrame *out,
+    int max_frames);
+
+void profiler_compute_stats(struct Profiler *p, struct ProfilerStats *stats);
+
+/* Draws the frame-time graph and, when a font is set, the percentile
+   summary. Call between rendering and presenting. */
+void profiler_draw_overlay(struct Profiler *p, SDL_Renderer *renderer);
+
+/* Writes every buffered frame as CSV. */
+bool profiler_write_csv(struct Profiler *p, const char *path);
+
+#endif /* PROFILER_H */
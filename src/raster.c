@@ -0,0 +1,689 @@
+#include "raster.h"
+
+#include <SDL3/SDL_intrin.h>
+
+#define RASTER_MIN_COMMANDS 256
+
+/* ----------------------------
+   Kernels
+   ---------------------------- */
+
+/* x * y / 255, rounded, for x and y in [0, 255] */
+static Uint32 mul_div255(Uint32 x, Uint32 y)
+{
+    const Uint32 t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static Uint32 blend_pixel(Uint32 d, Uint32 s)
+{
+    const Uint32 inv = 255 - (s >> 24);
+    Uint32 out = 0;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const Uint32 c = ((s >> shift) & 0xFF) +
+                         mul_div255((d >> shift) & 0xFF, inv);
+        out |= SDL_min(c, 255u) << shift;
+    }
+    return out;
+}
+
+static void fill_scalar(Uint32 *dst, int n, Uint32 color)
+{
+    for (int i = 0; i < n; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+static void blend_scalar(Uint32 *dst, const Uint32 *src, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        dst[i] = blend_pixel(dst[i], src[i]);
+    }
+}
+
+#if defined(SDL_SSE2_INTRINSICS)
+static void SDL_TARGETING("sse2") fill_sse2(Uint32 *dst, int n, Uint32 color)
+{
+    const __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_si128((__m128i *)(dst + i), c);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+/* Four 16-bit channels per pixel: d * (255 - alpha of s) / 255 */
+static __m128i SDL_TARGETING("sse2") scale_sse2(__m128i d, __m128i s)
+{
+    const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    const __m128i t =
+        _mm_add_epi16(_mm_mullo_epi16(d, inv), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void SDL_TARGETING("sse2") blend_sse2(Uint32 *dst, const Uint32 *src,
+    int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        const __m128i lo = scale_sse2(_mm_unpacklo_epi8(d, zero),
+            _mm_unpacklo_epi8(s, zero));
+        const __m128i hi = scale_sse2(_mm_unpackhi_epi8(d, zero),
+            _mm_unpackhi_epi8(s, zero));
+        _mm_storeu_si128((__m128i *)(dst + i),
+            _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+    blend_scalar(dst + i, src + i, n - i);
+}
+#endif
+
+#if defined(SDL_AVX2_INTRINSICS)
+static void SDL_TARGETING("avx2") fill_avx2(Uint32 *dst, int n, Uint32 color)
+{
+    const __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_si256((__m256i *)(dst + i), c);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+static __m256i SDL_TARGETING("avx2") scale_avx2(__m256i d, __m256i s)
+{
+    const __m256i a =
+        _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    const __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    const __m256i t =
+        _mm256_add_epi16(_mm256_mullo_epi16(d, inv), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+static void SDL_TARGETING("avx2") blend_avx2(Uint32 *dst, const Uint32 *src,
+    int n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+
+    /* Unpacking and packing both work within 128-bit lanes, so pixels come
+       back out in the order they went in */
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        const __m256i lo = scale_avx2(_mm256_unpacklo_epi8(d, zero),
+            _mm256_unpacklo_epi8(s, zero));
+        const __m256i hi = scale_avx2(_mm256_unpackhi_epi8(d, zero),
+            _mm256_unpackhi_epi8(s, zero));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+            _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s));
+    }
+    blend_scalar(dst + i, src + i, n - i);
+}
+#endif
+
+#if defined(SDL_NEON_INTRINSICS)
+static void fill_neon(Uint32 *dst, int n, Uint32 color)
+{
+    const uint32x4_t c = vdupq_n_u32(color);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_u32(dst + i, c);
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+/* d * inv / 255, rounded */
+static uint8x8_t scale_neon(uint8x8_t d, uint8x8_t inv)
+{
+    const uint16x8_t t = vmull_u8(d, inv);
+    return vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+}
+
+static void blend_neon(Uint32 *dst, const Uint32 *src, int n)
+{
+    int i = 0;
+
+    /* De-interleaved into one register per channel, 8 pixels at a time */
+    for (; i + 8 <= n; i += 8)
+    {
+        const uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+        const uint8x8_t inv = vmvn_u8(s.val[3]);
+        for (int c = 0; c < 4; c++)
+        {
+            d.val[c] = vqadd_u8(s.val[c], scale_neon(d.val[c], inv));
+        }
+        vst4_u8((uint8_t *)(dst + i), d);
+    }
+    blend_scalar(dst + i, src + i, n - i);
+}
+#endif
+
+static void choose_kernels(struct RasterKernels *k, bool simd)
+{
+    k->name = "scalar";
+    k->fill = fill_scalar;
+    k->blend = blend_scalar;
+    if (!simd)
+    {
+        return;
+    }
+#if defined(SDL_SSE2_INTRINSICS)
+    if (SDL_HasSSE2())
+    {
+        k->name = "sse2";
+        k->fill = fill_sse2;
+        k->blend = blend_sse2;
+    }
+#endif
+#if defined(SDL_AVX2_INTRINSICS)
+    if (SDL_HasAVX2())
+    {
+        k->name = "avx2";
+        k->fill = fill_avx2;
+        k->blend = blend_avx2;
+    }
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+    if (SDL_HasNEON())
+    {
+        k->name = "neon";
+        k->fill = fill_neon;
+        k->blend = blend_neon;
+    }
+#endif
+}
+
+/* ----------------------------
+   Recording
+   ---------------------------- */
+
+static Uint32 to_byte(float v)
+{
+    return (Uint32)(SDL_clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+/* ARGB8888, with the color scaled by alpha when premultiplied */
+static Uint32 pack(SDL_FColor c, bool premultiplied)
+{
+    const float a = SDL_clamp(c.a, 0.0f, 1.0f);
+    const float scale = premultiplied ? a : 1.0f;
+    return (to_byte(a) << 24) | (to_byte(c.r * scale) << 16) |
+           (to_byte(c.g * scale) << 8) | to_byte(c.b * scale);
+}
+
+/* Pixels whose centers fall inside rect */
+static SDL_Rect covered(const SDL_FRect *rect)
+{
+    SDL_Rect r;
+    r.x = (int)SDL_ceilf(rect->x - 0.5f);
+    r.y = (int)SDL_ceilf(rect->y - 0.5f);
+    r.w = (int)SDL_ceilf(rect->x + rect->w - 0.5f) - r.x;
+    r.h = (int)SDL_ceilf(rect->y + rect->h - 0.5f) - r.y;
+    return r;
+}
+
+static struct RasterCommand *push(struct Raster *r)
+{
+    if (r->command_count == r->command_capacity)
+    {
+        const int capacity = SDL_max(r->command_capacity * 2,
+            RASTER_MIN_COMMANDS);
+        struct RasterCommand *commands = (struct RasterCommand *)SDL_realloc(
+            r->commands, (size_t)capacity * sizeof(*commands));
+        if (!commands)
+        {
+            return NULL;
+        }
+        r->commands = commands;
+        r->command_capacity = capacity;
+    }
+    return &r->commands[r->command_count++];
+}
+
+static int SDLCALL worker(void *data);
+
+bool raster_init(struct Raster *r, SDL_Window *window, bool simd,
+    int threads)
+{
+    SDL_zerop(r);
+    r->window = window;
+    choose_kernels(&r->kernels, simd);
+
+    if (threads <= 0)
+    {
+        threads = SDL_GetNumLogicalCPUCores();
+    }
+    threads = SDL_clamp(threads, 1, RASTER_MAX_THREADS);
+    if (threads > 1)
+    {
+        r->lock = SDL_CreateMutex();
+        r->work = SDL_CreateCondition();
+        r->done = SDL_CreateCondition();
+        if (!r->lock || !r->work || !r->done)
+        {
+            raster_quit(r);
+            return false;
+        }
+    }
+    for (int i = 1; i < threads; i++)
+    {
+        SDL_Thread *thread = SDL_CreateThread(worker, "raster", r);
+        if (!thread)
+        {
+            SDL_Log("Rasterizing on %d threads (%s)", i, SDL_GetError());
+            break;
+        }
+        r->threads[r->thread_count++] = thread;
+    }
+    return true;
+}
+
+void raster_quit(struct Raster *r)
+{
+    if (r->lock)
+    {
+        SDL_LockMutex(r->lock);
+        r->quit = true;
+        SDL_BroadcastCondition(r->work);
+        SDL_UnlockMutex(r->lock);
+    }
+    for (int i = 0; i < r->thread_count; i++)
+    {
+        SDL_WaitThread(r->threads[i], NULL);
+    }
+
+    SDL_DestroyCondition(r->done);
+    SDL_DestroyCondition(r->work);
+    SDL_DestroyMutex(r->lock);
+    SDL_DestroySurface(r->staging);
+    SDL_free(r->commands);
+    SDL_free(r->bin_start);
+    SDL_free(r->bin_items);
+    SDL_zerop(r);
+}
+
+bool raster_begin(struct Raster *r, SDL_FColor clear)
+{
+    SDL_Surface *surface = SDL_GetWindowSurface(r->window);
+    r->target = NULL;
+    r->command_count = 0;
+    if (!surface)
+    {
+        return false;
+    }
+
+    r->target = surface;
+    if (surface->format != SDL_PIXELFORMAT_ARGB8888 &&
+        surface->format != SDL_PIXELFORMAT_XRGB8888)
+    {
+        /* Draw in our format, convert once when presenting */
+        if (!r->staging || r->staging->w != surface->w ||
+            r->staging->h != surface->h)
+        {
+            SDL_DestroySurface(r->staging);
+            r->staging = SDL_CreateSurface(surface->w, surface->h,
+                SDL_PIXELFORMAT_ARGB8888);
+            if (!r->staging)
+            {
+                return false;
+            }
+        }
+        r->target = r->staging;
+    }
+
+    r->clear = pack(clear, true);
+    return true;
+}
+
+void raster_fill_rect(struct Raster *r, const SDL_FRect *rect,
+    SDL_FColor color, SDL_BlendMode blend)
+{
+    struct RasterCommand *cmd = push(r);
+    if (!cmd)
+    {
+        return;
+    }
+    cmd->dst = covered(rect);
+    if (blend == SDL_BLENDMODE_NONE)
+    {
+        /* Replaces the pixels as given, like the renderer does */
+        cmd->op = RASTER_FILL;
+        cmd->color = pack(color, false);
+    }
+    else
+    {
+        cmd->color = pack(color, true);
+        cmd->op = (cmd->color >> 24) == 255 ? RASTER_FILL : RASTER_BLEND_FILL;
+    }
+}
+
+void raster_blit(struct Raster *r, const SDL_Surface *src,
+    const SDL_Rect *src_rect, const SDL_FRect *dst, SDL_FColor tint)
+{
+    struct RasterCommand *cmd = push(r);
+    if (!cmd)
+    {
+        return;
+    }
+    cmd->op = RASTER_BLIT;
+    cmd->dst = covered(dst);
+    cmd->color = pack(tint, true);
+    cmd->src = src;
+    if (src_rect)
+    {
+        cmd->src_rect = *src_rect;
+    }
+    else
+    {
+        cmd->src_rect.x = 0;
+        cmd->src_rect.y = 0;
+        cmd->src_rect.w = src->w;
+        cmd->src_rect.h = src->h;
+    }
+}
+
+/* ----------------------------
+   Rasterizing
+   ---------------------------- */
+
+static Uint32 tint_pixel(Uint32 p, Uint32 tint)
+{
+    Uint32 out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        out |= mul_div255((p >> shift) & 0xFF, (tint >> shift) & 0xFF)
+               << shift;
+    }
+    return out;
+}
+
+/* Draws the part of cmd inside clip */
+static void draw(const struct Raster *r, const struct RasterCommand *cmd,
+    const SDL_Rect *clip)
+{
+    const struct RasterKernels *k = &r->kernels;
+    SDL_Surface *t = r->target;
+    Uint32 row[RASTER_TILE_W];
+    SDL_Rect area;
+
+    if (!SDL_GetRectIntersection(&cmd->dst, clip, &area))
+    {
+        return;
+    }
+    if (cmd->op == RASTER_BLEND_FILL)
+    {
+        k->fill(row, area.w, cmd->color);
+    }
+
+    for (int y = area.y; y < area.y + area.h; y++)
+    {
+        Uint32 *out = (Uint32 *)((Uint8 *)t->pixels + y * t->pitch) + area.x;
+
+        switch (cmd->op)
+        {
+            case RASTER_FILL:
+                k->fill(out, area.w, cmd->color);
+                break;
+            case RASTER_BLEND_FILL:
+                k->blend(out, row, area.w);
+                break;
+            case RASTER_BLIT:
+            {
+                const SDL_Surface *src = cmd->src;
+                const SDL_Rect *s = &cmd->src_rect;
+                const int sy = s->y + (y - cmd->dst.y) * s->h / cmd->dst.h;
+                const Uint32 *in =
+                    (const Uint32 *)((const Uint8 *)src->pixels +
+                                     sy * src->pitch) + s->x;
+
+                if (s->w == cmd->dst.w && cmd->color == 0xFFFFFFFF)
+                {
+                    /* Unscaled and untinted: blend straight from the source */
+                    k->blend(out, in + (area.x - cmd->dst.x), area.w);
+                    break;
+                }
+                for (int x = 0; x < area.w; x++)
+                {
+                    const int sx = (area.x + x - cmd->dst.x) * s->w / cmd->dst.w;
+                    row[x] = in[sx];
+                }
+                if (cmd->color != 0xFFFFFFFF)
+                {
+                    for (int x = 0; x < area.w; x++)
+                    {
+                        row[x] = tint_pixel(row[x], cmd->color);
+                    }
+                }
+                k->blend(out, row, area.w);
+                break;
+            }
+        }
+    }
+}
+
+/* ----------------------------
+   Binning and tiles
+   ---------------------------- */
+
+/* The range of tiles cmd touches. False when it is off the target. */
+static bool tile_span(const struct Raster *r, const struct RasterCommand *cmd,
+    int *x0, int *y0, int *x1, int *y1)
+{
+    const SDL_Rect bounds = { 0, 0, r->target->w, r->target->h };
+    SDL_Rect area;
+
+    if (!SDL_GetRectIntersection(&cmd->dst, &bounds, &area))
+    {
+        return false;
+    }
+    *x0 = area.x / RASTER_TILE_W;
+    *y0 = area.y / RASTER_TILE_H;
+    *x1 = (area.x + area.w - 1) / RASTER_TILE_W;
+    *y1 = (area.y + area.h - 1) / RASTER_TILE_H;
+    return true;
+}
+
+static bool reserve(int **array, int *capacity, int wanted)
+{
+    if (wanted <= *capacity)
+    {
+        return true;
+    }
+    const int grown = SDL_max(wanted, *capacity * 2);
+    int *items = (int *)SDL_realloc(*array, (size_t)grown * sizeof(*items));
+    if (!items)
+    {
+        return false;
+    }
+    *array = items;
+    *capacity = grown;
+    return true;
+}
+
+/* Counting sort of the commands into per-tile lists. Commands keep their
+   submission order within a tile, so blending comes out the same as
+   drawing them one after the other. */
+static bool bin(struct Raster *r)
+{
+    int x0, y0, x1, y1;
+
+    r->tiles_x = (r->target->w + RASTER_TILE_W - 1) / RASTER_TILE_W;
+    r->tiles_y = (r->target->h + RASTER_TILE_H - 1) / RASTER_TILE_H;
+    const int tiles = r->tiles_x * r->tiles_y;
+    if (!reserve(&r->bin_start, &r->bin_tile_capacity, 2 * tiles + 1))
+    {
+        return false;
+    }
+    int *start = r->bin_start;
+    int *cursor = r->bin_start + tiles + 1;
+
+    SDL_memset(start, 0, (size_t)(tiles + 1) * sizeof(*start));
+    for (int i = 0; i < r->command_count; i++)
+    {
+        if (!tile_span(r, &r->commands[i], &x0, &y0, &x1, &y1))
+        {
+            continue;
+        }
+        for (int ty = y0; ty <= y1; ty++)
+        {
+            for (int tx = x0; tx <= x1; tx++)
+            {
+                start[ty * r->tiles_x + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < tiles; t++)
+    {
+        start[t + 1] += start[t];
+    }
+    if (!reserve(&r->bin_items, &r->bin_item_capacity,
+            SDL_max(start[tiles], 1)))
+    {
+        return false;
+    }
+
+    SDL_memcpy(cursor, start, (size_t)tiles * sizeof(*cursor));
+    for (int i = 0; i < r->command_count; i++)
+    {
+        if (!tile_span(r, &r->commands[i], &x0, &y0, &x1, &y1))
+        {
+            continue;
+        }
+        for (int ty = y0; ty <= y1; ty++)
+        {
+            for (int tx = x0; tx <= x1; tx++)
+            {
+                r->bin_items[cursor[ty * r->tiles_x + tx]++] = i;
+            }
+        }
+    }
+    return true;
+}
+
+static void draw_tile(const struct Raster *r, int t)
+{
+    const SDL_Surface *target = r->target;
+    const int tx = (t % r->tiles_x) * RASTER_TILE_W;
+    const int ty = (t / r->tiles_x) * RASTER_TILE_H;
+    const SDL_Rect tile = { tx, ty, SDL_min(RASTER_TILE_W, target->w - tx),
+        SDL_min(RASTER_TILE_H, target->h - ty) };
+    const struct RasterCommand clear = { RASTER_FILL, tile, r->clear, NULL,
+        { 0, 0, 0, 0 } };
+
+    draw(r, &clear, &tile);
+    for (int i = r->bin_start[t]; i < r->bin_start[t + 1]; i++)
+    {
+        draw(r, &r->commands[r->bin_items[i]], &tile);
+    }
+}
+
+/* Takes tiles until there are none left. Tiles never overlap, so threads
+   only share the counter. */
+static void draw_tiles(struct Raster *r)
+{
+    const int tiles = r->tiles_x * r->tiles_y;
+    int t;
+
+    while ((t = SDL_AddAtomicInt(&r->next_tile, 1)) < tiles)
+    {
+        draw_tile(r, t);
+    }
+}
+
+static int SDLCALL worker(void *data)
+{
+    struct Raster *r = (struct Raster *)data;
+    Uint32 frame = 0;
+
+    for (;;)
+    {
+        SDL_LockMutex(r->lock);
+        while (!r->quit && r->frame == frame)
+        {
+            SDL_WaitCondition(r->work, r->lock);
+        }
+        frame = r->frame;
+        const bool quit = r->quit;
+        SDL_UnlockMutex(r->lock);
+
+        if (quit)
+        {
+            return 0;
+        }
+        draw_tiles(r);
+
+        SDL_LockMutex(r->lock);
+        if (--r->busy == 0)
+        {
+            SDL_SignalCondition(r->done);
+        }
+        SDL_UnlockMutex(r->lock);
+    }
+}
+
+bool raster_present(struct Raster *r)
+{
+    SDL_Surface *t = r->target;
+
+    if (!t || !bin(r) || !SDL_LockSurface(t))
+    {
+        return false;
+    }
+
+    /* The mutex publishes the bins and commands to the workers, and their
+       pixels back to us */
+    SDL_SetAtomicInt(&r->next_tile, 0);
+    if (r->thread_count > 0)
+    {
+        SDL_LockMutex(r->lock);
+        r->frame++;
+        r->busy = r->thread_count;
+        SDL_BroadcastCondition(r->work);
+        SDL_UnlockMutex(r->lock);
+    }
+    draw_tiles(r);
+    if (r->thread_count > 0)
+    {
+        SDL_LockMutex(r->lock);
+        while (r->busy > 0)
+        {
+            SDL_WaitCondition(r->done, r->lock);
+        }
+        SDL_UnlockMutex(r->lock);
+    }
+    SDL_UnlockSurface(t);
+
+    if (t == r->staging &&
+        !SDL_BlitSurface(r->staging, NULL, SDL_GetWindowSurface(r->window),
+            NULL))
+    {
+        return false;
+    }
+    return SDL_UpdateWindowSurface(r->window);
+}
@@ -0,0 +1,102 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Software rasterizer (--renderer=raster)
+   ---------------------------- */
+
+/* 64x64 pixels of 32 bits: a tile stays in L1 while every command
+   touching it is drawn */
+#define RASTER_TILE_W 64
+#define RASTER_TILE_H 64
+
+/* Threads drawing tiles, the calling thread included */
+#define RASTER_MAX_THREADS 32
+
+/* Span kernels on 32-bit premultiplied ARGB, picked at runtime from what
+   the CPU supports */
+struct RasterKernels
+{
+    const char *name;
+    /* dst[0..n) = color */
+    void (*fill)(Uint32 *dst, int n, Uint32 color);
+    /* dst = src + dst * (1 - src alpha), i.e. premultiplied "over" */
+    void (*blend)(Uint32 *dst, const Uint32 *src, int n);
+};
+
+enum RasterOp
+{
+    RASTER_FILL,        /* opaque, or SDL_BLENDMODE_NONE */
+    RASTER_BLEND_FILL,
+    RASTER_BLIT,
+};
+
+struct RasterCommand
+{
+    enum RasterOp op;
+    SDL_Rect dst;         /* pixels covered, may extend past the target */
+    Uint32 color;         /* premultiplied fill color, or blit tint */
+    const SDL_Surface *src;
+    SDL_Rect src_rect;
+};
+
+/* Draws this app's draw list (solid rects, textured quads, text) into the
+   window surface without an SDL_Renderer. Draw calls only record
+   commands; raster_present() bins them by the tiles they touch and
+   rasterizes the tiles in parallel, each in submission order, then
+   updates the window. Blit sources must be premultiplied ARGB8888 and
+   stay unchanged until raster_present() returns. */
+struct Raster
+{
+    SDL_Window *window;
+    SDL_Surface *target;  /* what the tiles are drawn into this frame */
+    SDL_Surface *staging; /* when the window surface isn't 32-bit xRGB */
+    struct RasterKernels kernels;
+    Uint32 clear;
+    struct RasterCommand *commands;
+    int command_count;
+    int command_capacity;
+
+    /* Bins: the commands touching tile t are
+       commands[bin_items[bin_start[t] .. bin_start[t + 1])] */
+    int tiles_x, tiles_y;
+    int *bin_start;       /* tiles + 1 entries, then tiles of scratch */
+    int bin_tile_capacity;
+    int *bin_items;
+    int bin_item_capacity;
+
+    /* Workers wake when frame changes and take tiles from next_tile */
+    SDL_Mutex *lock;
+    SDL_Condition *work;
+    SDL_Condition *done;  /* signalled when the last worker is through */
+    SDL_Thread *threads[RASTER_MAX_THREADS - 1];
+    int thread_count;
+    Uint32 frame;
+    int busy;             /* workers not through the frame yet */
+    bool quit;
+    SDL_AtomicInt next_tile;
+};
+
+/* simd = false keeps to the scalar kernels, for comparison. threads
+   counts the calling thread; 0 uses every core and 1 starts no worker. */
+bool raster_init(struct Raster *r, SDL_Window *window, bool simd,
+    int threads);
+void raster_quit(struct Raster *r);
+
+/* Starts a frame cleared to color. Fails if the window has no surface. */
+bool raster_begin(struct Raster *r, SDL_FColor clear);
+
+void raster_fill_rect(struct Raster *r, const SDL_FRect *rect,
+    SDL_FColor color, SDL_BlendMode blend);
+
+/* Nearest-neighbour scaled copy of src_rect (NULL for all of src) onto
+   dst, blended over what is there and multiplied by tint */
+void raster_blit(struct Raster *r, const SDL_Surface *src,
+    const SDL_Rect *src_rect, const SDL_FRect *dst, SDL_FColor tint);
+
+/* Rasterizes the frame and shows it */
+bool raster_present(struct Raster *r);
+
+#endif /* RASTER_H */
@@ -0,0 +1,422 @@
+#include "scene.h"
+
+void scene_init(struct Scene *s, SDL_Renderer *renderer, struct Batch *batch)
+{
+    SDL_zerop(s);
+    s->renderer = renderer;
+    s->batch = batch;
+    s->full = true;
+}
+
+void scene_quit(struct Scene *s)
+{
+    if (s->target)
+    {
+        SDL_DestroyTexture(s->target);
+    }
+    SDL_free(s->nodes);
+    SDL_free(s->order);
+    SDL_zerop(s);
+}
+
+static struct SceneNode *get(struct Scene *s, int node)
+{
+    if (node < 0 || node >= s->node_count || !s->nodes[node].used)
+    {
+        return NULL;
+    }
+    return &s->nodes[node];
+}
+
+/* Adds r to the damage list, merged with every rectangle it overlaps so
+   no pixel is redrawn twice. Too many separate rectangles collapse into
+   their bounding box. */
+static void add_damage(struct Scene *s, const SDL_Rect *r)
+{
+    const SDL_Rect screen = { 0, 0, s->width, s->height };
+    SDL_Rect area;
+
+    if (s->full || !SDL_GetRectIntersection(r, &screen, &area))
+    {
+        return;
+    }
+
+    for (int i = 0; i < s->damage_count;)
+    {
+        if (SDL_HasRectIntersection(&s->damage[i], &area))
+        {
+            SDL_GetRectUnion(&s->damage[i], &area, &area);
+            s->damage[i] = s->damage[--s->damage_count];
+            i = 0; /* the union may now overlap one already passed */
+        }
+        else
+        {
+            i++;
+        }
+    }
+    if (s->damage_count == SCENE_MAX_DAMAGE)
+    {
+        for (int i = 0; i < s->damage_count; i++)
+        {
+            SDL_GetRectUnion(&s->damage[i], &area, &area);
+        }
+        s->damage_count = 0;
+    }
+    s->damage[s->damage_count++] = area;
+}
+
+int scene_add(struct Scene *s, int parent)
+{
+    int node = s->first_free;
+    while (node < s->node_count && s->nodes[node].used)
+    {
+        node++;
+    }
+    if (node == s->node_capacity)
+    {
+        const int grown = SDL_max(64, s->node_capacity * 2);
+        struct SceneNode *nodes = (struct SceneNode *)SDL_realloc(s->nodes,
+            (size_t)grown * sizeof(*nodes));
+        if (!nodes)
+        {
+            return -1;
+        }
+        s->nodes = nodes;
+        s->node_capacity = grown;
+    }
+    if (node == s->node_count)
+    {
+        s->node_count++;
+    }
+    s->first_free = node + 1;
+
+    struct SceneNode *n = &s->nodes[node];
+    SDL_zerop(n);
+    n->used = true;
+    n->visible = true;
+    n->kind = SCENE_NODE_GROUP;
+    n->parent = get(s, parent) ? parent : -1;
+    n->color = (SDL_FColor){ 1.0f, 1.0f, 1.0f, 1.0f };
+    n->blend = SDL_BLENDMODE_BLEND;
+    s->order_changed = true;
+    return node;
+}
+
+void scene_remove(struct Scene *s, int node)
+{
+    struct SceneNode *n = get(s, node);
+    if (!n)
+    {
+        return;
+    }
+
+    add_damage(s, &n->bounds);
+    n->used = false;
+    s->first_free = SDL_min(s->first_free, node);
+    s->order_changed = true;
+
+    for (int i = 0; i < s->node_count; i++)
+    {
+        if (s->nodes[i].used && s->nodes[i].parent == node)
+        {
+            scene_remove(s, i);
+        }
+    }
+}
+
+void scene_set_rect(struct Scene *s, int node, const SDL_FRect *rect)
+{
+    struct SceneNode *n = get(s, node);
+    if (n && (n->rect.x != rect->x || n->rect.y != rect->y ||
+                 n->rect.w != rect->w || n->rect.h != rect->h))
+    {
+        n->rect = *rect;
+        n->changed = true;
+    }
+}
+
+void scene_set_z(struct Scene *s, int node, int z)
+{
+    struct SceneNode *n = get(s, node);
+    if (n && n->z != z)
+    {
+        n->z = z;
+        n->changed = true;
+        s->order_changed = true;
+    }
+}
+
+void scene_set_visible(struct Scene *s, int node, bool visible)
+{
+    struct SceneNode *n = get(s, node);
+    if (n && n->visible != visible)
+    {
+        n->visible = visible;
+        n->changed = true;
+    }
+}
+
+static bool same_color(SDL_FColor a, SDL_FColor b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+void scene_set_fill(struct Scene *s, int node, SDL_FColor color,
+    SDL_BlendMode blend)
+{
+    struct SceneNode *n = get(s, node);
+    if (n && (n->kind != SCENE_NODE_FILL || !same_color(n->color, color) ||
+                 n->blend != blend))
+    {
+        n->kind = SCENE_NODE_FILL;
+        n->color = color;
+        n->blend = blend;
+        n->changed = true;
+    }
+}
+
+void scene_set_texture(struct Scene *s, int node, SDL_Texture *texture,
+    const SDL_FRect *src, SDL_FColor tint)
+{
+    struct SceneNode *n = get(s, node);
+    SDL_FRect area = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    if (!n)
+    {
+        return;
+    }
+    if (src)
+    {
+        area = *src;
+    }
+    else if (texture)
+    {
+        SDL_GetTextureSize(texture, &area.w, &area.h);
+    }
+    if (n->kind != SCENE_NODE_TEXTURE || n->texture != texture ||
+        n->src.x != area.x || n->src.y != area.y || n->src.w != area.w ||
+        n->src.h != area.h || !same_color(n->color, tint))
+    {
+        n->kind = SCENE_NODE_TEXTURE;
+        n->texture = texture;
+        n->src = area;
+        n->color = tint;
+        n->changed = true;
+    }
+}
+
+void scene_set_custom(struct Scene *s, int node, SceneDrawFunc draw,
+    void *userdata)
+{
+    struct SceneNode *n = get(s, node);
+    if (n && (n->kind != SCENE_NODE_CUSTOM || n->draw != draw ||
+                 n->userdata != userdata))
+    {
+        n->kind = SCENE_NODE_CUSTOM;
+        n->draw = draw;
+        n->userdata = userdata;
+        n->changed = true;
+    }
+}
+
+void scene_damage_node(struct Scene *s, int node)
+{
+    struct SceneNode *n = get(s, node);
+    if (n)
+    {
+        n->changed = true;
+    }
+}
+
+void scene_invalidate(struct Scene *s)
+{
+    s->full = true;
+}
+
+static int SDLCALL compare_z(void *userdata, const void *lhs, const void *rhs)
+{
+    const struct Scene *s = (const struct Scene *)userdata;
+    const int l = *(const int *)lhs;
+    const int r = *(const int *)rhs;
+    if (s->nodes[l].z != s->nodes[r].z)
+    {
+        return s->nodes[l].z < s->nodes[r].z ? -1 : 1;
+    }
+    return l - r;
+}
+
+static bool sort_nodes(struct Scene *s)
+{
+    if (s->node_count > s->order_capacity)
+    {
+        int *order = (int *)SDL_realloc(s->order,
+            (size_t)s->node_capacity * sizeof(*order));
+        if (!order)
+        {
+            return false;
+        }
+        s->order = order;
+        s->order_capacity = s->node_capacity;
+    }
+
+    s->order_count = 0;
+    for (int i = 0; i < s->node_count; i++)
+    {
+        if (s->nodes[i].used)
+        {
+            s->order[s->order_count++] = i;
+        }
+    }
+    SDL_qsort_r(s->order, (size_t)s->order_count, sizeof(*s->order), compare_z,
+        s);
+    s->order_changed = false;
+    return true;
+}
+
+/* Where node ends up on screen, and whether it shows at all: parents move
+   and hide their children */
+static bool place(const struct Scene *s, const struct SceneNode *n,
+    SDL_FRect *world)
+{
+    bool visible = n->visible && n->kind != SCENE_NODE_GROUP;
+
+    *world = n->rect;
+    for (int p = n->parent; p >= 0; p = s->nodes[p].parent)
+    {
+        world->x += s->nodes[p].rect.x;
+        world->y += s->nodes[p].rect.y;
+        visible = visible && s->nodes[p].visible;
+    }
+    return visible;
+}
+
+/* Compares every node with how it was last drawn and damages both where
+   it was and where it is now */
+static void collect_damage(struct Scene *s)
+{
+    SDL_FRect world;
+    SDL_Rect bounds;
+
+    for (int i = 0; i < s->node_count; i++)
+    {
+        struct SceneNode *n = &s->nodes[i];
+        if (!n->used)
+        {
+            continue;
+        }
+
+        SDL_zero(bounds);
+        if (place(s, n, &world) && world.w > 0.0f && world.h > 0.0f)
+        {
+            bounds.x = (int)SDL_floorf(world.x);
+            bounds.y = (int)SDL_floorf(world.y);
+            bounds.w = (int)SDL_ceilf(world.x + world.w) - bounds.x;
+            bounds.h = (int)SDL_ceilf(world.y + world.h) - bounds.y;
+        }
+        if (n->changed || !SDL_RectsEqual(&bounds, &n->bounds))
+        {
+            add_damage(s, &n->bounds);
+            add_damage(s, &bounds);
+        }
+        n->world = world;
+        n->bounds = bounds;
+        n->changed = false;
+    }
+}
+
+static void draw_node(struct Scene *s, const struct SceneNode *n)
+{
+    switch (n->kind)
+    {
+        case SCENE_NODE_FILL:
+            batch_fill_rect(s->batch, &n->world, n->color, n->blend);
+            break;
+        case SCENE_NODE_TEXTURE:
+            batch_texture(s->batch, n->texture, &n->src, &n->world, n->color);
+            break;
+        case SCENE_NODE_CUSTOM:
+            batch_flush(s->batch);
+            n->draw(n->userdata, &n->world);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Clears area to the background and draws every node touching it, in z
+   order, with anything outside clipped away */
+static void redraw(struct Scene *s, const SDL_Rect *area, SDL_FColor background)
+{
+    const SDL_FRect fill = { (float)area->x, (float)area->y, (float)area->w,
+        (float)area->h };
+
+    SDL_SetRenderClipRect(s->renderer, area);
+    batch_fill_rect(s->batch, &fill, background, SDL_BLENDMODE_NONE);
+    for (int i = 0; i < s->order_count; i++)
+    {
+        const struct SceneNode *n = &s->nodes[s->order[i]];
+        if (SDL_HasRectIntersection(&n->bounds, area))
+        {
+            draw_node(s, n);
+        }
+    }
+    batch_flush(s->batch);
+    s->redrawn += (Sint64)area->w * area->h;
+}
+
+bool scene_render(struct Scene *s, SDL_FColor background)
+{
+    int width, height;
+
+    if (!SDL_GetCurrentRenderOutputSize(s->renderer, &width, &height))
+    {
+        return false;
+    }
+    if (!s->target || width != s->width || height != s->height)
+    {
+        if (s->target)
+        {
+            SDL_DestroyTexture(s->target);
+        }
+        s->target = SDL_CreateTexture(s->renderer, SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!s->target)
+        {
+            return false;
+        }
+        /* Copied 1:1 over the whole screen, so nothing to blend or filter */
+        SDL_SetTextureBlendMode(s->target, SDL_BLENDMODE_NONE);
+        SDL_SetTextureScaleMode(s->target, SDL_SCALEMODE_NEAREST);
+        s->width = width;
+        s->height = height;
+        s->full = true;
+    }
+
+    if (s->order_changed && !sort_nodes(s))
+    {
+        return false;
+    }
+    collect_damage(s);
+    if (s->full)
+    {
+        s->damage[0] = (SDL_Rect){ 0, 0, width, height };
+        s->damage_count = 1;
+        s->full = false;
+    }
+
+    s->redrawn = 0;
+    if (s->damage_count > 0)
+    {
+        SDL_Texture *screen = SDL_GetRenderTarget(s->renderer);
+        batch_flush(s->batch);
+        SDL_SetRenderTarget(s->renderer, s->target);
+        for (int i = 0; i < s->damage_count; i++)
+        {
+            redraw(s, &s->damage[i], background);
+        }
+        SDL_SetRenderClipRect(s->renderer, NULL);
+        SDL_SetRenderTarget(s->renderer, screen);
+        s->damage_count = 0;
+    }
+    return SDL_RenderTexture(s->renderer, s->target, NULL, NULL);
+}
@@ -0,0 +1,110 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <SDL3/SDL.h>
+
+#include "batch.h"
+
+/* ----------------------------
+   Retained scene with dirty-rect redraws (--scene)
+   ---------------------------- */
+
+/* Damage rectangles kept apart before they are merged into one */
+#define SCENE_MAX_DAMAGE 16
+
+enum SceneNodeKind
+{
+    SCENE_NODE_GROUP,   /* draws nothing, only moves its children */
+    SCENE_NODE_FILL,
+    SCENE_NODE_TEXTURE,
+    SCENE_NODE_CUSTOM,  /* drawn by a callback, e.g. TTF_DrawRendererText */
+};
+
+typedef void (*SceneDrawFunc)(void *userdata, const SDL_FRect *rect);
+
+struct SceneNode
+{
+    bool used;
+    bool visible;
+    bool changed;         /* drawn differently from what bounds holds */
+    enum SceneNodeKind kind;
+    int parent;           /* -1 at the top level */
+    int z;                /* higher draws on top; ties go by handle */
+    SDL_FRect rect;       /* x, y relative to the parent's position */
+    SDL_Texture *texture;
+    SDL_FRect src;        /* texels */
+    SDL_FColor color;     /* fill color, or texture tint */
+    SDL_BlendMode blend;  /* fills only */
+    SceneDrawFunc draw;
+    void *userdata;
+    SDL_FRect world;      /* rect on screen when last drawn */
+    SDL_Rect bounds;      /* pixels covered when last drawn, empty if none */
+};
+
+/* Nodes are kept between frames and drawn into a texture the size of the
+   output. Setters only mark what actually changed; scene_render() then
+   redraws just the rectangles that changed, clipped, and copies the
+   texture to the screen. Setting every node every frame is fine: a node
+   set to what it already is costs nothing. Handles are indices into
+   nodes. */
+struct Scene
+{
+    SDL_Renderer *renderer;
+    struct Batch *batch;
+    SDL_Texture *target;
+    int width, height;
+
+    struct SceneNode *nodes;
+    int node_count;
+    int node_capacity;
+    int first_free;       /* no unused node below this */
+
+    int *order;           /* used handles sorted by z */
+    int order_count;
+    int order_capacity;
+    bool order_changed;
+
+    SDL_Rect damage[SCENE_MAX_DAMAGE];
+    int damage_count;
+    bool full;            /* redraw everything, e.g. after a resize */
+    Sint64 redrawn;       /* pixels redrawn by the last scene_render() */
+};
+
+/* Draws through batch, which must be on renderer */
+void scene_init(struct Scene *s, SDL_Renderer *renderer, struct Batch *batch);
+void scene_quit(struct Scene *s);
+
+/* Returns a handle to a new group node under parent (-1 for none), or -1
+   when out of memory. Setting a fill, texture or callback gives it
+   something to draw. */
+int scene_add(struct Scene *s, int parent);
+
+/* Removes node and its children */
+void scene_remove(struct Scene *s, int node);
+
+void scene_set_rect(struct Scene *s, int node, const SDL_FRect *rect);
+void scene_set_z(struct Scene *s, int node, int z);
+void scene_set_visible(struct Scene *s, int node, bool visible);
+
+void scene_set_fill(struct Scene *s, int node, SDL_FColor color,
+    SDL_BlendMode blend);
+
+/* src is in texels, NULL for the whole texture */
+void scene_set_texture(struct Scene *s, int node, SDL_Texture *texture,
+    const SDL_FRect *src, SDL_FColor tint);
+
+/* draw is called with the node's rect on screen and the batch flushed */
+void scene_set_custom(struct Scene *s, int node, SceneDrawFunc draw,
+    void *userdata);
+
+/* The node looks different without any of the above changing, e.g. new
+   text behind a custom node */
+void scene_damage_node(struct Scene *s, int node);
+
+/* Everything must be redrawn, e.g. on SDL_EVENT_RENDER_TARGETS_RESET */
+void scene_invalidate(struct Scene *s);
+
+/* Brings the texture up to date and draws it to the current target */
+bool scene_render(struct Scene *s, SDL_FColor background);
+
+#endif /* SCENE_H */
@@ -0,0 +1,183 @@
+#include "scheduler.h"
+
+/* Never simulate more than this much time in one frame, otherwise a long
+   stall makes us run hundreds of catch-up steps (spiral of death). */
+#define SCHEDULER_MAX_FRAME_NS (250 * SDL_NS_PER_MS)
+
+/* Frames without any change before we stop iterating. A few frames of grace
+   avoid flapping between idle and active while a pointer pauses briefly. */
+#define SCHEDULER_IDLE_FRAMES 30
+
+static void set_rate(struct Scheduler *s, const char *rate)
+{
+    SDL_strlcpy(s->active_rate, rate, sizeof(s->active_rate));
+    SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
+}
+
+/* Without a renderer the frames go through the window surface */
+static bool set_vsync(SDL_Renderer *renderer, SDL_Window *window, int vsync)
+{
+    if (renderer)
+    {
+        return SDL_SetRenderVSync(renderer, vsync);
+    }
+    return SDL_SetWindowSurfaceVSync(window, vsync);
+}
+
+bool scheduler_parse_pacing(const char *text, enum SchedulerPacing *pacing,
+    double *target_fps)
+{
+    if (SDL_strcmp(text, "vsync") == 0)
+    {
+        *pacing = SCHEDULER_PACING_VSYNC;
+        return true;
+    }
+    if (SDL_strcmp(text, "uncapped") == 0)
+    {
+        *pacing = SCHEDULER_PACING_UNCAPPED;
+        return true;
+    }
+
+    char *end = NULL;
+    double fps = SDL_strtod(text, &end);
+    if (end == text || *end != '\0' || fps <= 0.0)
+    {
+        return false;
+    }
+    *pacing = SCHEDULER_PACING_TARGET_FPS;
+    *target_fps = fps;
+    return true;
+}
+
+void scheduler_init(struct Scheduler *s, enum SchedulerPacing pacing,
+    double target_fps, double sim_hz)
+{
+    SDL_zerop(s);
+    s->pacing = pacing;
+    s->target_fps = target_fps > 0.0 ? target_fps : 60.0;
+    s->step_ns = (Uint64)(SDL_NS_PER_SECOND / (sim_hz > 0.0 ? sim_hz : 60.0));
+    s->max_frame_ns = SCHEDULER_MAX_FRAME_NS;
+    s->dirty = true;
+    SDL_strlcpy(s->active_rate, "0", sizeof(s->active_rate));
+}
+
+void scheduler_attach(struct Scheduler *s, SDL_Renderer *renderer,
+    SDL_Window *window)
+{
+    char rate[32];
+
+    if (s->pacing == SCHEDULER_PACING_VSYNC)
+    {
+#if defined(SDL_PLATFORM_EMSCRIPTEN)
+        /* Rate 0 is requestAnimationFrame, the browser's own vsync */
+        set_vsync(renderer, window, 1);
+        set_rate(s, "0");
+        SDL_Log("Pacing: requestAnimationFrame");
+        return;
+#endif
+        if (set_vsync(renderer, window, 1))
+        {
+            /* Presenting blocks on the display refresh */
+            set_rate(s, "0");
+            SDL_Log("Pacing: vsync");
+            return;
+        }
+
+        const SDL_DisplayMode *mode =
+            SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+        s->pacing = SCHEDULER_PACING_TARGET_FPS;
+        if (mode && mode->refresh_rate > 0.0f)
+        {
+            s->target_fps = mode->refresh_rate;
+        }
+        SDL_Log("VSync unavailable (%s), falling back to a fixed rate",
+            SDL_GetError());
+    }
+
+    set_vsync(renderer, window, SDL_RENDERER_VSYNC_DISABLED);
+    if (s->pacing == SCHEDULER_PACING_TARGET_FPS)
+    {
+        /* SDL waits between iterations with SDL_DelayPrecise (sleep, then
+           spin for the last stretch), outside of our frame. */
+        SDL_snprintf(rate, sizeof(rate), "%g", s->target_fps);
+        set_rate(s, rate);
+        SDL_Log("Pacing: %s fps", rate);
+    }
+    else
+    {
+        set_rate(s, "0");
+        SDL_Log("Pacing: uncapped");
+    }
+}
+
+int scheduler_begin_frame(struct Scheduler *s)
+{
+    if (s->lockstep)
+    {
+        /* Deterministic runs (benchmarks) must not depend on wall time */
+        s->accumulator_ns = 0;
+        return 1;
+    }
+
+    const Uint64 now = SDL_GetTicksNS();
+    Uint64 elapsed = s->last_ns ? now - s->last_ns : s->step_ns;
+    s->last_ns = now;
+
+    if (elapsed > s->max_frame_ns)
+    {
+        elapsed = s->max_frame_ns;
+    }
+    s->accumulator_ns += elapsed;
+
+    const int steps = (int)(s->accumulator_ns / s->step_ns);
+    s->accumulator_ns -= (Uint64)steps * s->step_ns;
+    return steps;
+}
+
+float scheduler_alpha(const struct Scheduler *s)
+{
+    return (float)((double)s->accumulator_ns / (double)s->step_ns);
+}
+
+void scheduler_invalidate(struct Scheduler *s)
+{
+    s->dirty = true;
+    s->quiet_frames = 0;
+
+    if (s->idle)
+    {
+        s->idle = false;
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, s->active_rate);
+
+        /* Time spent parked is not simulation time */
+        s->last_ns = 0;
+        s->accumulator_ns = 0;
+    }
+}
+
+bool scheduler_needs_render(const struct Scheduler *s)
+{
+    return s->dirty;
+}
+
+void scheduler_end_frame(struct Scheduler *s, bool rendered, bool animating)
+{
+    if (rendered)
+    {
+        s->dirty = false;
+    }
+    if (animating)
+    {
+        /* Interpolated positions change every frame until the steps settle */
+        scheduler_invalidate(s);
+        return;
+    }
+
+    if (!s->dirty && !s->idle && ++s->quiet_frames >= SCHEDULER_IDLE_FRAMES)
+    {
+        /* Not honored on the web, where iteration stays on
+           requestAnimationFrame; we still skip drawing there. */
+        s->idle = true;
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "waitevent");
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Fixed-timestep frame scheduler
+   ---------------------------- */
+
+enum SchedulerPacing
+{
+    SCHEDULER_PACING_VSYNC,      /* let SDL_RenderPresent block on vblank */
+    SCHEDULER_PACING_TARGET_FPS, /* SDL paces SDL_AppIterate to a rate */
+    SCHEDULER_PACING_UNCAPPED,   /* iterate as fast as possible */
+};
+
+struct Scheduler
+{
+    enum SchedulerPacing pacing;
+    double target_fps;
+
+    Uint64 step_ns;        /* length of one simulation step */
+    Uint64 max_frame_ns;   /* clamp for long stalls (debugger, resize) */
+    Uint64 accumulator_ns; /* simulated time owed to the update step */
+    Uint64 last_ns;        /* start of the previous frame */
+    bool lockstep;         /* one step per frame, ignoring real time */
+
+    /* Render governor */
+    bool dirty;            /* something visible changed since last render */
+    bool idle;             /* parked in "waitevent" until the next input */
+    int quiet_frames;      /* consecutive frames without changes */
+    char active_rate[32];  /* SDL_HINT_MAIN_CALLBACK_RATE while not idle */
+};
+
+/* Parses "vsync", "uncapped" or a frame rate such as "144" or "59.94". */
+bool scheduler_parse_pacing(const char *text, enum SchedulerPacing *pacing,
+    double *target_fps);
+
+void scheduler_init(struct Scheduler *s, enum SchedulerPacing pacing,
+    double target_fps, double sim_hz);
+
+/* Configures vsync (of the renderer, or of the window surface when renderer
+   is NULL) and SDL_HINT_MAIN_CALLBACK_RATE for the selected pacing, so
+   SDL_AppIterate itself never has to sleep. Falls back to TARGET_FPS at the
+   display refresh rate when vsync is unavailable. */
+void scheduler_attach(struct Scheduler *s, SDL_Renderer *renderer,
+    SDL_Window *window);
+
+/* Advances the clock and returns how many fixed steps the caller must run. */
+int scheduler_begin_frame(struct Scheduler *s);
+
+/* Fraction of a step left in the accumulator, for render interpolation. */
+float scheduler_alpha(const struct Scheduler *s);
+
+/* Marks the scene as changed. Leaves idle mode and restores the active
+   iteration rate if needed. Safe to call many times per frame. */
+void scheduler_invalidate(struct Scheduler *s);
+
+/* True when the current frame has to be drawn and presented. */
+bool scheduler_needs_render(const struct Scheduler *s);
+
+/* Ends a frame. animating tells whether the simulation is still moving;
+   after a short quiet period SDL_AppIterate is parked on "waitevent". */
+void scheduler_end_frame(struct Scheduler *s, bool rendered, bool animating);
+
+#endif /* SCHEDULER_H */
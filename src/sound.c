@@ -0,0 +1,348 @@
+#include "sound.h"
+
+#if defined(WITH_MIXER)
+
+/* Largest single read issued by the prefetch thread */
+#define PREFETCH_CHUNK (16 * 1024)
+
+struct Prefetch
+{
+    SDL_IOStream *src;
+    SDL_Thread *thread;
+    SDL_Mutex *lock;
+    SDL_Condition *has_space; /* signalled when the reader consumed data */
+    SDL_Condition *has_data;  /* signalled when the thread filled some */
+    Uint8 *buffer;
+    size_t capacity;
+    size_t start;             /* ring index of the read position */
+    size_t count;             /* bytes buffered from the read position */
+    Sint64 position;          /* file offset of buffer[start] */
+    Sint64 size;
+    Uint32 generation;        /* bumped by seeks; older fills are dropped */
+    bool eof;
+    bool error;
+    bool quit;
+};
+
+/* Only this thread touches src. It writes into the free part of the ring
+   without the lock: the reader never looks past start + count, and a
+   seek while the read is in flight just makes the result stale. */
+static int SDLCALL prefetch_thread(void *data)
+{
+    struct Prefetch *pf = (struct Prefetch *)data;
+    Sint64 src_offset = pf->position;
+
+    SDL_LockMutex(pf->lock);
+    for (;;)
+    {
+        while (!pf->quit &&
+               (pf->count == pf->capacity || pf->eof || pf->error))
+        {
+            SDL_WaitCondition(pf->has_space, pf->lock);
+        }
+        if (pf->quit)
+        {
+            break;
+        }
+
+        const Uint32 generation = pf->generation;
+        const Sint64 offset = pf->position + (Sint64)pf->count;
+        const size_t index = (pf->start + pf->count) % pf->capacity;
+        size_t n = SDL_min(pf->capacity - pf->count, pf->capacity - index);
+        n = SDL_min(n, (size_t)PREFETCH_CHUNK);
+        SDL_UnlockMutex(pf->lock);
+
+        size_t got = 0;
+        SDL_IOStatus status = SDL_IO_STATUS_ERROR;
+        if (src_offset == offset ||
+            SDL_SeekIO(pf->src, offset, SDL_IO_SEEK_SET) == offset)
+        {
+            got = SDL_ReadIO(pf->src, pf->buffer + index, n);
+            status = SDL_GetIOStatus(pf->src);
+            src_offset = offset + (Sint64)got;
+        }
+        else
+        {
+            src_offset = -1;
+        }
+
+        SDL_LockMutex(pf->lock);
+        if (generation == pf->generation)
+        {
+            pf->count += got;
+            if (got == 0)
+            {
+                pf->eof = (status == SDL_IO_STATUS_EOF);
+                pf->error = !pf->eof;
+            }
+            SDL_BroadcastCondition(pf->has_data);
+        }
+    }
+    SDL_UnlockMutex(pf->lock);
+    return 0;
+}
+
+static size_t SDLCALL prefetch_read(void *userdata, void *ptr, size_t size,
+    SDL_IOStatus *status)
+{
+    struct Prefetch *pf = (struct Prefetch *)userdata;
+    Uint8 *out = (Uint8 *)ptr;
+    size_t total = 0;
+
+    SDL_LockMutex(pf->lock);
+    while (total < size)
+    {
+        /* Underrun: only now does the caller wait on storage */
+        while (pf->count == 0 && !pf->eof && !pf->error)
+        {
+            SDL_WaitCondition(pf->has_data, pf->lock);
+        }
+        if (pf->count == 0)
+        {
+            *status = pf->eof ? SDL_IO_STATUS_EOF : SDL_IO_STATUS_ERROR;
+            break;
+        }
+
+        size_t n = SDL_min(size - total, pf->count);
+        n = SDL_min(n, pf->capacity - pf->start);
+        SDL_memcpy(out + total, pf->buffer + pf->start, n);
+        pf->start = (pf->start + n) % pf->capacity;
+        pf->count -= n;
+        pf->position += (Sint64)n;
+        total += n;
+        SDL_SignalCondition(pf->has_space);
+    }
+    SDL_UnlockMutex(pf->lock);
+    return total;
+}
+
+static Sint64 SDLCALL prefetch_seek(void *userdata, Sint64 offset,
+    SDL_IOWhence whence)
+{
+    struct Prefetch *pf = (struct Prefetch *)userdata;
+    Sint64 target;
+
+    SDL_LockMutex(pf->lock);
+    switch (whence)
+    {
+        case SDL_IO_SEEK_SET:
+            target = offset;
+            break;
+        case SDL_IO_SEEK_CUR:
+            target = pf->position + offset;
+            break;
+        default:
+            target = pf->size + offset;
+            break;
+    }
+    if (target < 0)
+    {
+        SDL_UnlockMutex(pf->lock);
+        return SDL_SetError("Seek before the start of the stream");
+    }
+
+    if (target >= pf->position && target <= pf->position + (Sint64)pf->count)
+    {
+        /* Inside the buffer, e.g. a decoder skipping a chunk */
+        const size_t skip = (size_t)(target - pf->position);
+        pf->start = (pf->start + skip) % pf->capacity;
+        pf->count -= skip;
+    }
+    else
+    {
+        pf->start = 0;
+        pf->count = 0;
+        pf->eof = false;
+        pf->error = false;
+        pf->generation++;
+    }
+    pf->position = target;
+    SDL_SignalCondition(pf->has_space);
+    SDL_UnlockMutex(pf->lock);
+    return target;
+}
+
+static Sint64 SDLCALL prefetch_size(void *userdata)
+{
+    return ((const struct Prefetch *)userdata)->size;
+}
+
+static void destroy_prefetch(struct Prefetch *pf)
+{
+    SDL_DestroyCondition(pf->has_data);
+    SDL_DestroyCondition(pf->has_space);
+    SDL_DestroyMutex(pf->lock);
+    SDL_free(pf->buffer);
+    SDL_free(pf);
+}
+
+static bool SDLCALL prefetch_close(void *userdata)
+{
+    struct Prefetch *pf = (struct Prefetch *)userdata;
+
+    SDL_LockMutex(pf->lock);
+    pf->quit = true;
+    SDL_SignalCondition(pf->has_space);
+    SDL_UnlockMutex(pf->lock);
+    SDL_WaitThread(pf->thread, NULL);
+
+    const bool closed = pf->src ? SDL_CloseIO(pf->src) : true;
+    destroy_prefetch(pf);
+    return closed;
+}
+
+SDL_IOStream *sound_open_prefetch(SDL_IOStream *src, size_t readahead)
+{
+    struct Prefetch *pf = (struct Prefetch *)SDL_calloc(1, sizeof(*pf));
+    SDL_IOStreamInterface iface;
+    SDL_IOStream *io = NULL;
+
+    if (!pf)
+    {
+        return src;
+    }
+    pf->src = src;
+    pf->capacity = readahead;
+    pf->position = SDL_TellIO(src);
+    pf->size = SDL_GetIOSize(src);
+    pf->buffer = (Uint8 *)SDL_malloc(readahead);
+    pf->lock = SDL_CreateMutex();
+    pf->has_space = SDL_CreateCondition();
+    pf->has_data = SDL_CreateCondition();
+
+    SDL_INIT_INTERFACE(&iface);
+    iface.size = prefetch_size;
+    iface.seek = prefetch_seek;
+    iface.read = prefetch_read;
+    iface.close = prefetch_close;
+
+    if (pf->position >= 0 && pf->buffer && pf->lock && pf->has_space &&
+        pf->has_data)
+    {
+        io = SDL_OpenIO(&iface, pf);
+    }
+    if (!io)
+    {
+        SDL_Log("Streaming without prefetch (%s)", SDL_GetError());
+        destroy_prefetch(pf);
+        return src;
+    }
+
+    pf->thread = SDL_CreateThread(prefetch_thread, "prefetch", pf);
+    if (!pf->thread)
+    {
+        SDL_Log("Streaming without prefetch (%s)", SDL_GetError());
+        pf->src = NULL; /* hand src back instead of closing it */
+        SDL_CloseIO(io);
+        return src;
+    }
+    return io;
+}
+
+bool sound_load(struct Sound *snd, struct AudioCache *cache, const char *path,
+    enum SoundPolicy policy, size_t readahead)
+{
+    SDL_zerop(snd);
+    snd->cache = cache;
+    SDL_strlcpy(snd->path, path, sizeof(snd->path));
+    snd->readahead = readahead ? readahead : SOUND_DEFAULT_READAHEAD;
+
+    if (policy == SOUND_AUTO)
+    {
+        SDL_IOStream *io = vfs_open(cache->vfs, path);
+        if (!io)
+        {
+            return false;
+        }
+        const Sint64 size = SDL_GetIOSize(io);
+        SDL_CloseIO(io);
+        policy = size > SOUND_STREAM_THRESHOLD ? SOUND_STREAM : SOUND_PREDECODE;
+    }
+    snd->policy = policy;
+
+    if (policy == SOUND_PREDECODE)
+    {
+        snd->audio = audio_cache_acquire(cache, path);
+        return snd->audio != NULL;
+    }
+
+    SDL_IOStream *src = vfs_open(cache->vfs, path);
+    if (!src)
+    {
+        return false;
+    }
+    snd->track = MIX_CreateTrack(cache->mixer);
+    if (!snd->track)
+    {
+        SDL_CloseIO(src);
+        return false;
+    }
+    /* Files served from a mapped archive are already in memory */
+    const bool in_memory = SDL_GetPointerProperty(SDL_GetIOProperties(src),
+                               SDL_PROP_IOSTREAM_MEMORY_POINTER, NULL) != NULL;
+    if (!in_memory)
+    {
+        src = sound_open_prefetch(src, snd->readahead);
+    }
+    if (!MIX_SetTrackIOStream(snd->track, src, true))
+    {
+        MIX_DestroyTrack(snd->track);
+        snd->track = NULL;
+        return false;
+    }
+    return true;
+}
+
+void sound_free(struct Sound *snd)
+{
+    if (snd->track)
+    {
+        MIX_DestroyTrack(snd->track); /* closes the stream */
+        snd->track = NULL;
+    }
+    if (snd->audio)
+    {
+        audio_cache_release(snd->cache, snd->audio);
+        snd->audio = NULL;
+    }
+}
+
+bool sound_play(struct Sound *snd, int loops)
+{
+    if (!snd->track)
+    {
+        if (!snd->audio)
+        {
+            return SDL_SetError("%s is not loaded", snd->path);
+        }
+        snd->track = MIX_CreateTrack(snd->cache->mixer);
+        if (!snd->track)
+        {
+            return false;
+        }
+        MIX_SetTrackAudio(snd->track, snd->audio);
+    }
+
+    SDL_PropertiesID options = 0;
+    if (loops != 0)
+    {
+        options = SDL_CreateProperties();
+        SDL_SetNumberProperty(options, MIX_PROP_PLAY_LOOPS_NUMBER, loops);
+    }
+    const bool ok = MIX_PlayTrack(snd->track, options);
+    if (options)
+    {
+        SDL_DestroyProperties(options);
+    }
+    return ok;
+}
+
+void sound_stop(struct Sound *snd)
+{
+    if (snd->track)
+    {
+        MIX_StopTrack(snd->track, 0);
+    }
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "audiocache.h"
+
+/* ----------------------------
+   Sound assets: predecoded or streamed
+   ---------------------------- */
+
+/* Files above this size are streamed when the policy is SOUND_AUTO */
+#define SOUND_STREAM_THRESHOLD (1024 * 1024)
+#define SOUND_DEFAULT_READAHEAD (64 * 1024)
+
+enum SoundPolicy
+{
+    SOUND_AUTO,
+    SOUND_PREDECODE, /* whole file decoded to PCM up front, for effects */
+    SOUND_STREAM,    /* decoded while playing, for music and ambience */
+};
+
+/* Predecoded sounds hold their PCM in audio. Streamed sounds own one
+   track fed by a prefetching SDL_IOStream, so a multi-minute file costs
+   its read-ahead buffer instead of its PCM. */
+struct Sound
+{
+    enum SoundPolicy policy; /* resolved, never SOUND_AUTO */
+    struct AudioCache *cache;
+    MIX_Audio *audio;        /* predecoded only, a cache reference */
+    MIX_Track *track;        /* streamed, or once sound_play() ran */
+    char path[256];
+    size_t readahead;
+};
+
+/* Predecoded sounds come from cache, so loading the same file twice
+   shares its PCM. readahead is the prefetch buffer size for streamed
+   sounds; 0 picks the default. */
+bool sound_load(struct Sound *snd, struct AudioCache *cache, const char *path,
+    enum SoundPolicy policy, size_t readahead);
+void sound_free(struct Sound *snd);
+
+/* (Re)starts the sound from the top on its own track, for music and
+   ambience; loops is -1 for forever. Short effects should go through the
+   voice pool with snd->audio instead. */
+bool sound_play(struct Sound *snd, int loops);
+void sound_stop(struct Sound *snd);
+
+/* Wraps src in a stream whose reads are served from a buffer that a
+   background thread keeps filled ahead of the read position, so the mixer
+   thread doesn't wait on storage. Takes ownership of src. Returns src
+   itself when no thread can be started. */
+SDL_IOStream *sound_open_prefetch(SDL_IOStream *src, size_t readahead);
+#endif
+
+#endif /* SOUND_H */
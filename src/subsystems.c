@@ -0,0 +1,114 @@
+#include "subsystems.h"
+
+#if defined(WITH_TTF)
+#include <SDL3_ttf/SDL_ttf.h>
+#endif
+
+#include "trace.h"
+
+#if defined(WITH_MIXER)
+static void start_mixer(struct Subsystems *s)
+{
+    int span = trace_begin("MIX_Init");
+    s->mixer_init = MIX_Init();
+    trace_end(span);
+    if (!s->mixer_init)
+    {
+        SDL_Log("MIX_Init failed (%s)", SDL_GetError());
+        return;
+    }
+
+    span = trace_begin("mixer device");
+    s->mixer = MIX_CreateMixerDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
+    trace_end(span);
+    if (!s->mixer)
+    {
+        SDL_Log("Couldn't create mixer, running without audio: %s",
+            SDL_GetError());
+        return;
+    }
+
+    span = trace_begin("decoders");
+    SDL_Log("Available MIXER decoders:");
+    const int num_decoders = MIX_GetNumAudioDecoders();
+    if (num_decoders < 0)
+    {
+        SDL_Log(" - [error (%s)]", SDL_GetError());
+    }
+    else if (num_decoders == 0)
+    {
+        SDL_Log(" - [none]");
+    }
+    else
+    {
+        for (int i = 0; i < num_decoders; i++)
+        {
+            SDL_Log(" - %s", MIX_GetAudioDecoder(i));
+        }
+    }
+    trace_end(span);
+}
+#endif
+
+static void start_all(struct Subsystems *s)
+{
+    (void)s;
+#if defined(WITH_MIXER)
+    start_mixer(s);
+#endif
+#if defined(WITH_TTF)
+    const int span = trace_begin("TTF_Init");
+    s->ttf = TTF_Init();
+    trace_end(span);
+    if (!s->ttf)
+    {
+        SDL_Log("TTF_Init failed, running without text: %s", SDL_GetError());
+    }
+#endif
+}
+
+static int SDLCALL run(void *data)
+{
+    struct Subsystems *s = (struct Subsystems *)data;
+    SDL_Event event;
+
+    start_all(s);
+    SDL_SetAtomicInt(&s->finished, 1);
+
+    SDL_zero(event);
+    event.type = s->ready_event;
+    SDL_PushEvent(&event);
+    return 0;
+}
+
+void subsystems_start(struct Subsystems *s)
+{
+    SDL_zerop(s);
+    s->ready_event = SDL_RegisterEvents(1);
+    s->thread = SDL_CreateThread(run, "subsystems", s);
+    if (!s->thread)
+    {
+        SDL_Log("Starting subsystems synchronously (%s)", SDL_GetError());
+        start_all(s);
+        SDL_SetAtomicInt(&s->finished, 1);
+    }
+}
+
+bool subsystems_poll(struct Subsystems *s)
+{
+    if (s->collected || !SDL_GetAtomicInt(&s->finished))
+    {
+        return false;
+    }
+    /* Joining makes the thread's results visible here */
+    SDL_WaitThread(s->thread, NULL);
+    s->thread = NULL;
+    s->collected = true;
+    return true;
+}
+
+void subsystems_wait(struct Subsystems *s)
+{
+    SDL_WaitThread(s->thread, NULL);
+    s->thread = NULL;
+}
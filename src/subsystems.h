@@ -0,0 +1,44 @@
+#ifndef SUBSYSTEMS_H
+#define SUBSYSTEMS_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+#endif
+
+/* ----------------------------
+   Deferred subsystem start-up
+   ---------------------------- */
+
+/* Brings up the optional libraries that can be slow to start (opening
+   the audio device can take hundreds of milliseconds) on a thread of
+   their own, so the window shows its first frame without them. Anything
+   needing a renderer, like the TTF text engine, is left to the caller
+   once they are ready. */
+struct Subsystems
+{
+    SDL_Thread *thread;
+    Uint32 ready_event;   /* pushed when the thread finishes */
+    SDL_AtomicInt finished;
+    bool collected;       /* subsystems_poll() already returned true */
+#if defined(WITH_MIXER)
+    bool mixer_init;      /* MIX_Init succeeded */
+    MIX_Mixer *mixer;     /* NULL if there is no audio */
+#endif
+#if defined(WITH_TTF)
+    bool ttf;             /* TTF_Init succeeded */
+#endif
+};
+
+/* Starts the thread, or does the work right away if it can't */
+void subsystems_start(struct Subsystems *s);
+
+/* Returns true exactly once, on the first call after everything is up
+   (or failed to come up). The results are only valid from then on. */
+bool subsystems_poll(struct Subsystems *s);
+
+/* Blocks until subsystems_poll() would return true */
+void subsystems_wait(struct Subsystems *s);
+
+#endif /* SUBSYSTEMS_H */
@@ -0,0 +1,151 @@
+#include "trace.h"
+
+struct TraceSpan
+{
+    char name[TRACE_NAME_MAX];
+    SDL_ThreadID thread;
+    Uint64 begin;          /* performance counter */
+    SDL_AtomicU32 closed;  /* end is valid */
+    Uint64 end;
+};
+
+static struct
+{
+    Uint64 origin;
+    Uint64 frequency;
+    SDL_ThreadID main_thread;
+    SDL_AtomicInt count;   /* spans claimed, may exceed TRACE_MAX_SPANS */
+    struct TraceSpan spans[TRACE_MAX_SPANS];
+} g_trace;
+
+static double to_us(Uint64 ticks)
+{
+    return (double)ticks * 1e6 / (double)g_trace.frequency;
+}
+
+static int span_count(void)
+{
+    return SDL_min(SDL_GetAtomicInt(&g_trace.count), TRACE_MAX_SPANS);
+}
+
+void trace_init(void)
+{
+    g_trace.frequency = SDL_GetPerformanceFrequency();
+    g_trace.origin = SDL_GetPerformanceCounter();
+    g_trace.main_thread = SDL_GetCurrentThreadID();
+}
+
+int trace_begin(const char *name)
+{
+    const int span = SDL_AddAtomicInt(&g_trace.count, 1);
+    if (span >= TRACE_MAX_SPANS)
+    {
+        return -1;
+    }
+
+    struct TraceSpan *s = &g_trace.spans[span];
+    SDL_strlcpy(s->name, name, sizeof(s->name));
+    s->thread = SDL_GetCurrentThreadID();
+    s->begin = SDL_GetPerformanceCounter();
+    return span;
+}
+
+void trace_end(int span)
+{
+    if (span >= 0)
+    {
+        struct TraceSpan *s = &g_trace.spans[span];
+        s->end = SDL_GetPerformanceCounter();
+        SDL_SetAtomicU32(&s->closed, 1);
+    }
+}
+
+/* Closed span on the main thread not inside another one */
+static bool is_top_level(int i)
+{
+    struct TraceSpan *s = &g_trace.spans[i];
+
+    if (!SDL_GetAtomicU32(&s->closed) || s->thread != g_trace.main_thread)
+    {
+        return false;
+    }
+    for (int j = 0; j < i; j++)
+    {
+        struct TraceSpan *outer = &g_trace.spans[j];
+        if (outer->thread == s->thread && outer->begin <= s->begin &&
+            (!SDL_GetAtomicU32(&outer->closed) || outer->end >= s->end))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void trace_report(void)
+{
+    char line[1024];
+    const int count = span_count();
+    int length = SDL_snprintf(line, sizeof(line), "startup: %.1f ms",
+        to_us(SDL_GetPerformanceCounter() - g_trace.origin) / 1000.0);
+
+    for (int i = 0; i < count && length < (int)sizeof(line); i++)
+    {
+        if (is_top_level(i))
+        {
+            const struct TraceSpan *s = &g_trace.spans[i];
+            length += SDL_snprintf(line + length, sizeof(line) - length,
+                ", %s %.1f", s->name, to_us(s->end - s->begin) / 1000.0);
+        }
+    }
+    SDL_Log("%s", line);
+}
+
+/* Name as a JSON string body */
+static void escape(char *dst, size_t size, const char *src)
+{
+    size_t n = 0;
+
+    for (; *src && n + 2 < size; src++)
+    {
+        if (*src == '"' || *src == '\\')
+        {
+            dst[n++] = '\\';
+        }
+        dst[n++] = (unsigned char)*src < 0x20 ? ' ' : *src;
+    }
+    dst[n] = '\0';
+}
+
+bool trace_write(const char *path)
+{
+    char name[2 * TRACE_NAME_MAX];
+    const int count = span_count();
+
+    SDL_IOStream *io = SDL_IOFromFile(path, "w");
+    if (!io)
+    {
+        return false;
+    }
+
+    SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    SDL_IOprintf(io,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+        "\"tid\":%" SDL_PRIu64 ",\"args\":{\"name\":\"main\"}}",
+        (Uint64)g_trace.main_thread);
+    for (int i = 0; i < count; i++)
+    {
+        struct TraceSpan *s = &g_trace.spans[i];
+        if (!SDL_GetAtomicU32(&s->closed))
+        {
+            continue;
+        }
+        escape(name, sizeof(name), s->name);
+        SDL_IOprintf(io,
+            ",\n{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,"
+            "\"tid\":%" SDL_PRIu64 ",\"ts\":%.3f,\"dur\":%.3f}",
+            name, (Uint64)s->thread, to_us(s->begin - g_trace.origin),
+            to_us(s->end - s->begin));
+    }
+    SDL_IOprintf(io, "\n]}\n");
+    return SDL_CloseIO(io);
+}
@@ -0,0 +1,31 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Startup tracer
+   ---------------------------- */
+
+#define TRACE_MAX_SPANS 256
+#define TRACE_NAME_MAX 48
+
+/* Starts the clock every span is measured against. Call first thing. */
+void trace_init(void);
+
+/* Opens a span named name (copied) on the calling thread and returns its
+   id for trace_end(), or -1 once TRACE_MAX_SPANS are used up. Spans may
+   nest. Safe to call from any thread. */
+int trace_begin(const char *name);
+void trace_end(int span);
+
+/* Logs one line: the time until now and the main thread's top-level
+   spans, in order. */
+void trace_report(void);
+
+/* Writes every closed span as Chrome trace events ("ph": "X"), for
+   chrome://tracing or ui.perfetto.dev. Spans still running when this is
+   called are left out. */
+bool trace_write(const char *path);
+
+#endif /* TRACE_H */
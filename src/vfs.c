@@ -0,0 +1,237 @@
+#include "vfs.h"
+
+#include "pak.h"
+
+#if defined(SDL_PLATFORM_WINDOWS)
+#include <windows.h>
+#define VFS_MMAP_WIN32
+#elif (defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)) && \
+    !defined(SDL_PLATFORM_EMSCRIPTEN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFS_MMAP_POSIX
+#endif
+
+SDL_COMPILE_TIME_ASSERT(pak_header, sizeof(struct PakHeader) == 16);
+SDL_COMPILE_TIME_ASSERT(pak_entry, sizeof(struct PakEntry) == 32);
+
+/* Maps path read-only. Falls back to reading it whole where there is no
+   mapping (the web build's files already live in memory anyway). */
+static bool map_file(struct Vfs *v, const char *path)
+{
+#if defined(VFS_MMAP_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        HANDLE mapping = NULL;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        }
+        CloseHandle(file);
+        if (mapping)
+        {
+            v->blob = (const Uint8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0,
+                0, 0);
+            if (v->blob)
+            {
+                v->blob_size = (size_t)size.QuadPart;
+                v->mapping = mapping;
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+    }
+#elif defined(VFS_MMAP_POSIX)
+    const int fd = open(path, O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        void *p = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (p != MAP_FAILED)
+        {
+            v->blob = (const Uint8 *)p;
+            v->blob_size = (size_t)st.st_size;
+            return true;
+        }
+    }
+#endif
+
+    v->blob = (const Uint8 *)SDL_LoadFile(path, &v->blob_size);
+    v->loaded = v->blob != NULL;
+    return v->loaded;
+}
+
+static void unmap_file(struct Vfs *v)
+{
+    if (v->loaded)
+    {
+        SDL_free((void *)v->blob);
+    }
+    else if (v->blob)
+    {
+#if defined(VFS_MMAP_WIN32)
+        UnmapViewOfFile(v->blob);
+        CloseHandle((HANDLE)v->mapping);
+#elif defined(VFS_MMAP_POSIX)
+        munmap((void *)v->blob, v->blob_size);
+#endif
+    }
+    v->blob = NULL;
+    v->blob_size = 0;
+    v->mapping = NULL;
+    v->loaded = false;
+}
+
+void vfs_init(struct Vfs *v, const char *root)
+{
+    SDL_zerop(v);
+    SDL_strlcpy(v->root, root, sizeof(v->root));
+}
+
+bool vfs_mount(struct Vfs *v, const char *path)
+{
+    struct PakHeader header;
+
+    vfs_unmount(v);
+    if (!map_file(v, path))
+    {
+        return false;
+    }
+
+    if (v->blob_size < sizeof(header))
+    {
+        vfs_unmount(v);
+        return SDL_SetError("%s: not an asset archive", path);
+    }
+    SDL_memcpy(&header, v->blob, sizeof(header));
+    const Uint32 count = SDL_Swap32LE(header.count);
+    const Uint32 names_size = SDL_Swap32LE(header.names_size);
+    const Uint64 names_start =
+        sizeof(header) + (Uint64)count * sizeof(struct PakEntry);
+
+    if (SDL_memcmp(header.magic, PAK_MAGIC, 4) != 0 ||
+        SDL_Swap32LE(header.version) != PAK_VERSION ||
+        names_start + names_size > v->blob_size)
+    {
+        vfs_unmount(v);
+        return SDL_SetError("%s: not a version %d asset archive", path,
+            PAK_VERSION);
+    }
+
+    /* Lookups trust every entry from here on, so a corrupt or truncated
+       archive is rejected whole rather than read past the end of names */
+    for (Uint32 i = 0; i < count; i++)
+    {
+        struct PakEntry e;
+        SDL_memcpy(&e, v->blob + sizeof(header) + (size_t)i * sizeof(e),
+            sizeof(e));
+        if ((Uint64)SDL_Swap32LE(e.name_offset) + SDL_Swap32LE(e.name_length) >
+            names_size)
+        {
+            vfs_unmount(v);
+            return SDL_SetError("%s: entry %u names past the name block",
+                path, (unsigned)i);
+        }
+    }
+
+    v->count = count;
+    v->entries = v->blob + sizeof(header);
+    v->names = (const char *)v->blob + names_start;
+    return true;
+}
+
+void vfs_unmount(struct Vfs *v)
+{
+    unmap_file(v);
+    v->entries = NULL;
+    v->names = NULL;
+    v->count = 0;
+}
+
+static SDL_IOStream *open_packed(const struct Vfs *v, const char *name)
+{
+    const size_t length = SDL_strlen(name);
+    const Uint32 hash = pak_hash(name, length);
+    const Uint8 *entries = (const Uint8 *)v->entries;
+    Uint32 lo = 0;
+    Uint32 hi = v->count;
+
+    /* Binary search on (hash, name). Entries may be unaligned in a loaded
+       blob, so copy each one out. */
+    while (lo < hi)
+    {
+        const Uint32 mid = lo + (hi - lo) / 2;
+        struct PakEntry e;
+        SDL_memcpy(&e, entries + (size_t)mid * sizeof(e), sizeof(e));
+
+        const Uint32 e_hash = SDL_Swap32LE(e.hash);
+        int order;
+        if (e_hash != hash)
+        {
+            order = e_hash < hash ? -1 : 1;
+        }
+        else
+        {
+            const Uint32 e_length = SDL_Swap32LE(e.name_length);
+            const char *e_name = v->names + SDL_Swap32LE(e.name_offset);
+            order = SDL_strncmp(e_name, name, SDL_min(e_length, length));
+            if (order == 0 && e_length != length)
+            {
+                order = e_length < length ? -1 : 1;
+            }
+        }
+
+        if (order == 0)
+        {
+            const Uint64 offset = SDL_Swap64LE(e.offset);
+            const Uint64 size = SDL_Swap64LE(e.size);
+            if (size > v->blob_size || offset > v->blob_size - size)
+            {
+                SDL_SetError("%s: truncated archive entry", name);
+                return NULL;
+            }
+            return SDL_IOFromConstMem(v->blob + offset, (size_t)size);
+        }
+        if (order < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+SDL_IOStream *vfs_open(const struct Vfs *v, const char *name)
+{
+    char path[512];
+
+    if (v->count > 0)
+    {
+        SDL_IOStream *io = open_packed(v, name);
+        if (io)
+        {
+            return io;
+        }
+    }
+
+    SDL_snprintf(path, sizeof(path), "%s%s", v->root, name);
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io && v->root[0])
+    {
+        io = SDL_IOFromFile(name, "rb");
+    }
+    return io;
+}
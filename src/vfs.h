@@ -0,0 +1,36 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <SDL3/SDL.h>
+
+/* ----------------------------
+   Virtual file system
+   ---------------------------- */
+
+/* Resolves logical asset names ("sprites/crate.png") against a mounted
+   archive (see pak.h), falling back to loose files under root. A mounted
+   archive is mapped into memory once and every file is served from it
+   through SDL_IOFromConstMem, with no per-file open. Read-only after
+   mounting, so vfs_open is safe from any thread. */
+struct Vfs
+{
+    char root[256];
+    const Uint8 *blob;   /* mapped archive, NULL when nothing is mounted */
+    size_t blob_size;
+    const void *entries; /* struct PakEntry[count], inside blob */
+    const char *names;
+    Uint32 count;
+    void *mapping;       /* platform handle for unmapping */
+    bool loaded;         /* blob came from SDL_LoadFile, not a mapping */
+};
+
+void vfs_init(struct Vfs *v, const char *root);
+
+/* Maps the archive at path. On failure loose files keep working. */
+bool vfs_mount(struct Vfs *v, const char *path);
+void vfs_unmount(struct Vfs *v);
+
+/* Opens name from the archive, else root/name, else name as given */
+SDL_IOStream *vfs_open(const struct Vfs *v, const char *name);
+
+#endif /* VFS_H */
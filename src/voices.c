@@ -0,0 +1,107 @@
+#include "voices.h"
+
+#if defined(WITH_MIXER)
+
+void voices_init(struct VoicePool *pool, MIX_Mixer *mixer)
+{
+    SDL_zerop(pool);
+    pool->mixer = mixer;
+}
+
+void voices_quit(struct VoicePool *pool)
+{
+    for (int i = 0; i < pool->voice_count; i++)
+    {
+        MIX_DestroyTrack(pool->voices[i].track);
+    }
+    pool->voice_count = 0;
+    pool->sound_count = 0;
+}
+
+int voices_add_sound(struct VoicePool *pool, MIX_Audio *audio, int max_voices)
+{
+    if (pool->sound_count == VOICES_MAX_SOUNDS ||
+        pool->voice_count + max_voices > VOICES_MAX || max_voices <= 0)
+    {
+        SDL_SetError("Voice pool exhausted");
+        return -1;
+    }
+
+    const int id = pool->sound_count;
+    struct VoiceSound *sound = &pool->sounds[id];
+    sound->audio = audio;
+    sound->first = pool->voice_count;
+    sound->count = 0;
+    SDL_snprintf(sound->tag, sizeof(sound->tag), "sfx%d", id);
+
+    for (int i = 0; i < max_voices; i++)
+    {
+        MIX_Track *track = MIX_CreateTrack(pool->mixer);
+        if (!track)
+        {
+            break;
+        }
+        if (!MIX_SetTrackAudio(track, audio) || !MIX_TagTrack(track, sound->tag))
+        {
+            MIX_DestroyTrack(track);
+            break;
+        }
+
+        struct Voice *voice = &pool->voices[pool->voice_count++];
+        voice->track = track;
+        voice->started = 0;
+        voice->gain = 1.0f;
+        sound->count++;
+    }
+
+    if (sound->count == 0)
+    {
+        return -1;
+    }
+    pool->sound_count++;
+    return id;
+}
+
+bool voices_play(struct VoicePool *pool, int sound, float gain)
+{
+    if (sound < 0 || sound >= pool->sound_count)
+    {
+        return false;
+    }
+
+    const struct VoiceSound *s = &pool->sounds[sound];
+    struct Voice *pick = NULL;
+    for (int i = s->first; i < s->first + s->count; i++)
+    {
+        struct Voice *voice = &pool->voices[i];
+        if (!MIX_TrackPlaying(voice->track))
+        {
+            pick = voice;
+            break;
+        }
+        if (!pick || voice->gain < pick->gain ||
+            (voice->gain == pick->gain && voice->started < pick->started))
+        {
+            pick = voice;
+        }
+    }
+
+    pick->started = ++pool->plays;
+    if (pick->gain != gain)
+    {
+        pick->gain = gain;
+        MIX_SetTrackGain(pick->track, gain);
+    }
+    /* Restarts the track from the top if it was being stolen */
+    return MIX_PlayTrack(pick->track, 0);
+}
+
+void voices_stop(struct VoicePool *pool, int sound)
+{
+    if (sound >= 0 && sound < pool->sound_count)
+    {
+        MIX_StopTag(pool->mixer, pool->sounds[sound].tag, 0);
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef VOICES_H
+#define VOICES_H
+
+#include <SDL3/SDL.h>
+
+#if defined(WITH_MIXER)
+#include <SDL3_mixer/SDL_mixer.h>
+
+/* ----------------------------
+   Sound effect voice pool
+   ---------------------------- */
+
+#define VOICES_MAX 32
+#define VOICES_MAX_SOUNDS 16
+
+struct Voice
+{
+    MIX_Track *track;
+    Uint64 started; /* play counter value when last started */
+    float gain;
+};
+
+/* A sound owns voices [first, first + count) of the pool. Every track is
+   tagged and bound to its audio up front, so playing never allocates. */
+struct VoiceSound
+{
+    MIX_Audio *audio;
+    int first;
+    int count;
+    char tag[16];   /* "sfx<n>", for MIX_StopTag / MIX_SetTagGain */
+};
+
+struct VoicePool
+{
+    MIX_Mixer *mixer;
+    struct Voice voices[VOICES_MAX];
+    int voice_count;
+    struct VoiceSound sounds[VOICES_MAX_SOUNDS];
+    int sound_count;
+    Uint64 plays;
+};
+
+void voices_init(struct VoicePool *pool, MIX_Mixer *mixer);
+void voices_quit(struct VoicePool *pool);
+
+/* Reserves max_voices tracks for audio, which caps how many copies of it
+   can overlap. Returns a sound id, or -1 once the pool is used up. */
+int voices_add_sound(struct VoicePool *pool, MIX_Audio *audio, int max_voices);
+
+/* Starts the sound on an idle voice of its own. When all are busy, the
+   quietest one is stolen, the oldest among equals. */
+bool voices_play(struct VoicePool *pool, int sound, float gain);
+
+void voices_stop(struct VoicePool *pool, int sound);
+#endif
+
+#endif /* VOICES_H */
@@ -0,0 +1,178 @@
+/* Host tool: converts an asset into the cooked format described in
+   src/cook.h, so the game loads it without decoding.
+
+   sdlcross_cooker [--freq=<hz>] [--channels=<n>] <input> <output>
+
+   .wav files become float PCM at the given rate and channel count
+   (default 48000 Hz stereo, what mixers usually open the device with).
+   Anything else is taken as an image and becomes ARGB8888 pixels, the
+   format of the atlas pages it is copied into. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#if defined(WITH_IMAGE)
+#include <SDL3_image/SDL_image.h>
+#endif
+
+#include "../src/cook.h"
+
+#define COOK_PIXEL_FORMAT SDL_PIXELFORMAT_ARGB8888
+#define COOK_AUDIO_FORMAT SDL_AUDIO_F32LE
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static bool has_suffix(const char *s, const char *suffix)
+{
+    const size_t n = strlen(s);
+    const size_t m = strlen(suffix);
+    return n >= m && SDL_strcasecmp(s + n - m, suffix) == 0;
+}
+
+static bool write_cooked(const char *path, const struct CookHeader *h,
+    const void *payload)
+{
+    unsigned char header[sizeof(struct CookHeader)];
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, COOK_MAGIC, 4);
+    put32(header + 4, COOK_VERSION);
+    put32(header + 8, h->kind);
+    put32(header + 12, h->format);
+    put32(header + 16, h->width);
+    put32(header + 20, h->height);
+    put32(header + 24, h->pitch);
+    put32(header + 28, h->channels);
+    put32(header + 32, h->freq);
+    put64(header + 40, h->size);
+
+    FILE *out = fopen(path, "wb");
+    if (!out)
+    {
+        return false;
+    }
+    fwrite(header, sizeof(header), 1, out);
+    fwrite(payload, 1, (size_t)h->size, out);
+    return fclose(out) == 0;
+}
+
+static bool cook_image(const char *input, const char *output)
+{
+    struct CookHeader h;
+
+#if defined(WITH_IMAGE)
+    SDL_Surface *loaded = IMG_Load(input);
+#else
+    SDL_Surface *loaded = SDL_LoadBMP(input);
+#endif
+    if (!loaded)
+    {
+        return false;
+    }
+    SDL_Surface *surface = SDL_ConvertSurface(loaded, COOK_PIXEL_FORMAT);
+    SDL_DestroySurface(loaded);
+    if (!surface)
+    {
+        return false;
+    }
+
+    memset(&h, 0, sizeof(h));
+    h.kind = COOK_IMAGE;
+    h.format = COOK_PIXEL_FORMAT;
+    h.width = (uint32_t)surface->w;
+    h.height = (uint32_t)surface->h;
+    h.pitch = (uint32_t)surface->pitch;
+    h.size = (uint64_t)surface->pitch * (uint64_t)surface->h;
+    const bool ok = write_cooked(output, &h, surface->pixels);
+    SDL_DestroySurface(surface);
+    return ok;
+}
+
+static bool cook_audio(const char *input, const char *output, int freq,
+    int channels)
+{
+    SDL_AudioSpec src_spec;
+    Uint8 *src = NULL;
+    Uint32 src_len = 0;
+    Uint8 *dst = NULL;
+    int dst_len = 0;
+    struct CookHeader h;
+
+    if (!SDL_LoadWAV(input, &src_spec, &src, &src_len))
+    {
+        return false;
+    }
+    const SDL_AudioSpec dst_spec = { COOK_AUDIO_FORMAT, channels, freq };
+    const bool converted = SDL_ConvertAudioSamples(&src_spec, src,
+        (int)src_len, &dst_spec, &dst, &dst_len);
+    SDL_free(src);
+    if (!converted)
+    {
+        return false;
+    }
+
+    memset(&h, 0, sizeof(h));
+    h.kind = COOK_AUDIO;
+    h.format = COOK_AUDIO_FORMAT;
+    h.channels = (uint32_t)channels;
+    h.freq = (uint32_t)freq;
+    h.size = (uint64_t)dst_len;
+    const bool ok = write_cooked(output, &h, dst);
+    SDL_free(dst);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int freq = 48000;
+    int channels = 2;
+    int arg = 1;
+
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++)
+    {
+        if (strncmp(argv[arg], "--freq=", 7) == 0)
+        {
+            freq = atoi(argv[arg] + 7);
+        }
+        else if (strncmp(argv[arg], "--channels=", 11) == 0)
+        {
+            channels = atoi(argv[arg] + 11);
+        }
+    }
+    if (argc - arg != 2 || freq <= 0 || channels <= 0)
+    {
+        fprintf(stderr,
+            "usage: %s [--freq=<hz>] [--channels=<n>] <input> <output>\n",
+            argv[0]);
+        return 2;
+    }
+
+    const char *input = argv[arg];
+    const char *output = argv[arg + 1];
+    const bool ok = has_suffix(input, ".wav")
+                        ? cook_audio(input, output, freq, channels)
+                        : cook_image(input, output);
+    if (!ok)
+    {
+        fprintf(stderr, "%s: can't cook %s: %s\n", argv[0], input,
+            SDL_GetError()[0] ? SDL_GetError() : "write failed");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/* Host tool: packs assets into the archive format described in src/pak.h.
+
+   sdlcross_pack <output.pak> <asset root> <name>... [-C <root> <name>...]
+
+   Each name is a path relative to the current asset root and becomes the
+   logical name the game opens it by. -C switches the root for the names
+   after it, e.g. to pick up files generated in the build tree. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/pak.h"
+
+struct Input
+{
+    const char *name;
+    uint32_t hash;
+    unsigned char *data;
+    uint64_t size;
+};
+
+static int compare_inputs(const void *a, const void *b)
+{
+    const struct Input *x = (const struct Input *)a;
+    const struct Input *y = (const struct Input *)b;
+    if (x->hash != y->hash)
+    {
+        return x->hash < y->hash ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+static unsigned char *read_file(const char *path, uint64_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *data = NULL;
+    long length;
+
+    if (!f)
+    {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (length = ftell(f)) >= 0 &&
+        fseek(f, 0, SEEK_SET) == 0)
+    {
+        data = (unsigned char *)malloc(length > 0 ? (size_t)length : 1);
+        if (data && fread(data, 1, (size_t)length, f) != (size_t)length)
+        {
+            free(data);
+            data = NULL;
+        }
+        *size = (uint64_t)length;
+    }
+    fclose(f);
+    return data;
+}
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint64_t align_up(uint64_t v)
+{
+    return (v + PAK_ALIGN - 1) & ~(uint64_t)(PAK_ALIGN - 1);
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned char zeros[PAK_ALIGN];
+    char path[4096];
+
+    if (argc < 3)
+    {
+        fprintf(stderr,
+            "usage: %s <output.pak> <asset root> <name>... "
+            "[-C <root> <name>...]\n",
+            argv[0]);
+        return 2;
+    }
+
+    struct Input *inputs =
+        (struct Input *)calloc((size_t)argc, sizeof(*inputs));
+    const char *root = argv[2];
+    uint32_t names_size = 0;
+    int count = 0;
+
+    for (int arg = 3; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-C") == 0 && arg + 1 < argc)
+        {
+            root = argv[++arg];
+            continue;
+        }
+
+        struct Input *in = &inputs[count++];
+        in->name = argv[arg];
+        in->hash = pak_hash(in->name, strlen(in->name));
+        snprintf(path, sizeof(path), "%s/%s", root, in->name);
+        in->data = read_file(path, &in->size);
+        if (!in->data)
+        {
+            fprintf(stderr, "%s: can't read %s\n", argv[0], path);
+            return 1;
+        }
+        names_size += (uint32_t)strlen(in->name);
+    }
+    qsort(inputs, (size_t)count, sizeof(*inputs), compare_inputs);
+
+    FILE *out = fopen(argv[1], "wb");
+    if (!out)
+    {
+        fprintf(stderr, "%s: can't create %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    unsigned char header[sizeof(struct PakHeader)];
+    memcpy(header, PAK_MAGIC, 4);
+    put32(header + 4, PAK_VERSION);
+    put32(header + 8, (uint32_t)count);
+    put32(header + 12, names_size);
+    fwrite(header, sizeof(header), 1, out);
+
+    const uint64_t names_start =
+        sizeof(struct PakHeader) + (uint64_t)count * sizeof(struct PakEntry);
+    uint64_t offset = align_up(names_start + names_size);
+    uint32_t name_offset = 0;
+    for (int i = 0; i < count; i++)
+    {
+        unsigned char entry[sizeof(struct PakEntry)];
+        const uint32_t length = (uint32_t)strlen(inputs[i].name);
+        put32(entry, inputs[i].hash);
+        put32(entry + 4, name_offset);
+        put32(entry + 8, length);
+        put32(entry + 12, 0);
+        put64(entry + 16, offset);
+        put64(entry + 24, inputs[i].size);
+        fwrite(entry, sizeof(entry), 1, out);
+        name_offset += length;
+        offset = align_up(offset + inputs[i].size);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        fwrite(inputs[i].name, 1, strlen(inputs[i].name), out);
+    }
+
+    uint64_t written = names_start + names_size;
+    for (int i = 0; i < count; i++)
+    {
+        fwrite(zeros, 1, (size_t)(align_up(written) - written), out);
+        written = align_up(written);
+        fwrite(inputs[i].data, 1, (size_t)inputs[i].size, out);
+        written += inputs[i].size;
+        free(inputs[i].data);
+    }
+    free(inputs);
+
+    /* A short write (a full disk) sticks in the error flag; without this
+       the build would go on with a truncated archive */
+    const int failed = ferror(out);
+    if (fclose(out) != 0 || failed)
+    {
+        fprintf(stderr, "%s: error writing %s\n", argv[0], argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}